@@ -4,7 +4,17 @@
 // Refer to the lambert shader files for useful comments
 
 uniform mat4 u_Model;
-uniform mat4 u_ViewProj;
+
+// Per-frame values shared by every shader, uploaded once per frame.
+// Must match FrameUniforms::Data in frameuniforms.h.
+layout(std140) uniform FrameUniforms {
+    mat4 u_ViewProj;    // The matrix that defines the camera's transformation.
+    mat4 u_ViewProjInv; // Its inverse, to turn screen points back into world space
+    vec4 u_Eye;         // Camera position, in xyz
+    int u_Time;         // Elapsed time in milliseconds
+    float u_TimeOfDay;  // Hours, from 0 to 24
+    float u_Weather;    // 0 for clear skies, up to 1 in a storm
+};
 
 in vec4 vs_Pos;
 in vec4 vs_Col;
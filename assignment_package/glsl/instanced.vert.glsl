@@ -7,9 +7,16 @@
 //This simultaneous transformation allows your program to run much faster, especially when rendering
 //geometry with millions of vertices.
 
-uniform mat4 u_ViewProj;    // The matrix that defines the camera's transformation.
-                            // We've written a static matrix for you to use for HW2,
-                            // but in HW3 you'll have to generate one yourself
+// Per-frame values shared by every shader, uploaded once per frame.
+// Must match FrameUniforms::Data in frameuniforms.h.
+layout(std140) uniform FrameUniforms {
+    mat4 u_ViewProj;    // The matrix that defines the camera's transformation.
+    mat4 u_ViewProjInv; // Its inverse, to turn screen points back into world space
+    vec4 u_Eye;         // Camera position, in xyz
+    int u_Time;         // Elapsed time in milliseconds
+    float u_TimeOfDay;  // Hours, from 0 to 24
+    float u_Weather;    // 0 for clear skies, up to 1 in a storm
+};
 
 in vec4 vs_Pos;             // The array of vertex positions passed to the shader
 in vec4 vs_Nor;             // The array of vertex normals passed to the shader
@@ -12,9 +12,17 @@
 // position, light position, and vertex color.
 
 uniform sampler2D u_Texture;
-uniform int u_Time;
-uniform float u_TimeOfDay;
-uniform float u_Weather;
+
+// Per-frame values shared by every shader, uploaded once per frame.
+// Must match FrameUniforms::Data in frameuniforms.h.
+layout(std140) uniform FrameUniforms {
+    mat4 u_ViewProj;    // The matrix that defines the camera's transformation.
+    mat4 u_ViewProjInv; // Its inverse, to turn screen points back into world space
+    vec4 u_Eye;         // Camera position, in xyz
+    int u_Time;         // Elapsed time in milliseconds
+    float u_TimeOfDay;  // Hours, from 0 to 24
+    float u_Weather;    // 0 for clear skies, up to 1 in a storm
+};
 
 // These are the interpolated values out of the rasterizer, so you can't know
 // their specific values without knowing the vertices that contributed to them
@@ -8,19 +8,20 @@
 //This simultaneous transformation allows your program to run much faster, especially when rendering
 //geometry with millions of vertices.
 
-uniform mat4 u_Model;       // The matrix that defines the transformation of the
-                            // object we're rendering. In this assignment,
-                            // this will be the result of traversing your scene graph.
-
-uniform mat4 u_ModelInvTr;  // The inverse transpose of the model matrix.
-                            // This allows us to transform the object's normals properly
-                            // if the object has been non-uniformly scaled.
-
-uniform mat4 u_ViewProj;    // The matrix that defines the camera's transformation.
-                            // We've written a static matrix for you to use for HW2,
-                            // but in HW3 you'll have to generate one yourself
-
-uniform float u_TimeOfDay;
+// Terrain is the only thing drawn with this shader, and chunk meshes are
+// buffered with their positions already in world space, so there is no
+// model matrix, and normals need no inverse transpose at all.
+
+// Per-frame values shared by every shader, uploaded once per frame.
+// Must match FrameUniforms::Data in frameuniforms.h.
+layout(std140) uniform FrameUniforms {
+    mat4 u_ViewProj;    // The matrix that defines the camera's transformation.
+    mat4 u_ViewProjInv; // Its inverse, to turn screen points back into world space
+    vec4 u_Eye;         // Camera position, in xyz
+    int u_Time;         // Elapsed time in milliseconds
+    float u_TimeOfDay;  // Hours, from 0 to 24
+    float u_Weather;    // 0 for clear skies, up to 1 in a storm
+};
 
 in vec4 vs_Pos;             // The array of vertex positions passed to the shader
 
@@ -41,15 +42,9 @@ void main()
     fs_UV = vs_UV;
     fs_Pos = vs_Pos;                   // Pass the vertex colors to the fragment shader for interpolation
 
-    mat3 invTranspose = mat3(u_ModelInvTr);
-    fs_Nor = vec4(invTranspose * vec3(vs_Nor), 0);          // Pass the vertex normals to the fragment shader for interpolation.
-                                                            // Transform the geometry's normals by the inverse transpose of the
-                                                            // model matrix. This is necessary to ensure the normals remain
-                                                            // perpendicular to the surface after the surface is transformed by
-                                                            // the model matrix.
-
+    fs_Nor = vec4(vec3(vs_Nor), 0);          // Pass the vertex normals to the fragment shader for interpolation.
 
-    vec4 modelposition = u_Model * vs_Pos;   // Temporarily store the transformed vertex positions for use below
+    vec4 modelposition = vs_Pos;   // Already in world space
 
     vec3 sunAngle = vec3(sin(u_TimeOfDay * PI / 12.f), cos(u_TimeOfDay * PI / 12.f), 0);
     fs_LightVec = vec4(sunAngle, 0);
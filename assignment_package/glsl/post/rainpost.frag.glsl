@@ -6,8 +6,17 @@
 in vec2 fs_UV;
 
 uniform sampler2D u_Texture;
-uniform int u_Time;
-uniform float u_Weather;
+
+// Per-frame values shared by every shader, uploaded once per frame.
+// Must match FrameUniforms::Data in frameuniforms.h.
+layout(std140) uniform FrameUniforms {
+    mat4 u_ViewProj;    // The matrix that defines the camera's transformation.
+    mat4 u_ViewProjInv; // Its inverse, to turn screen points back into world space
+    vec4 u_Eye;         // Camera position, in xyz
+    int u_Time;         // Elapsed time in milliseconds
+    float u_TimeOfDay;  // Hours, from 0 to 24
+    float u_Weather;    // 0 for clear skies, up to 1 in a storm
+};
 
 out vec4 out_Col;
 
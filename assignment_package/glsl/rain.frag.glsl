@@ -12,8 +12,17 @@
 // position, light position, and vertex color.
 
 uniform sampler2D u_Texture;
-uniform int u_Time;
-uniform float u_Weather;
+
+// Per-frame values shared by every shader, uploaded once per frame.
+// Must match FrameUniforms::Data in frameuniforms.h.
+layout(std140) uniform FrameUniforms {
+    mat4 u_ViewProj;    // The matrix that defines the camera's transformation.
+    mat4 u_ViewProjInv; // Its inverse, to turn screen points back into world space
+    vec4 u_Eye;         // Camera position, in xyz
+    int u_Time;         // Elapsed time in milliseconds
+    float u_TimeOfDay;  // Hours, from 0 to 24
+    float u_Weather;    // 0 for clear skies, up to 1 in a storm
+};
 
 // These are the interpolated values out of the rasterizer, so you can't know
 // their specific values without knowing the vertices that contributed to them
@@ -28,10 +37,8 @@ out vec4 out_Col; // This is the final output color that you will see on your
 void main()
 {
     // Material base color (before shading)
-    vec2 uv = fs_UV.xy;
-    uv.y *= 5;
-    uv.y += u_Time * 0.0015;
-    vec4 diffuseColor = texture(u_Texture, mod(uv, 1));
+    // Each drop is one whole sheet of the texture, moved by the vertex shader
+    vec4 diffuseColor = texture(u_Texture, fs_UV.xy);
     // Compute final shaded color
     out_Col = vec4(diffuseColor.rgb, diffuseColor.a * 0.75 * u_Weather);
 }
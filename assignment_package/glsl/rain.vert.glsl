@@ -1,56 +1,52 @@
 #version 150
 // ^ Change this to version 130 if you have compatibility issues
 
-//This is a vertex shader. While it is called a "shader" due to outdated conventions, this file
-//is used to apply matrix transformations to the arrays of vertex data passed to it.
-//Since this code is run on your GPU, each vertex is transformed simultaneously.
-//If it were run on your CPU, each vertex would have to be processed in a FOR loop, one at a time.
-//This simultaneous transformation allows your program to run much faster, especially when rendering
-//geometry with millions of vertices.
-
-uniform mat4 u_Model;       // The matrix that defines the transformation of the
-                            // object we're rendering. In this assignment,
-                            // this will be the result of traversing your scene graph.
-
-uniform mat4 u_ModelInvTr;  // The inverse transpose of the model matrix.
-                            // This allows us to transform the object's normals properly
-                            // if the object has been non-uniformly scaled.
-
-uniform mat4 u_ViewProj;    // The matrix that defines the camera's transformation.
-                            // We've written a static matrix for you to use for HW2,
-                            // but in HW3 you'll have to generate one yourself
-
-in vec4 vs_Pos;             // The array of vertex positions passed to the shader
-
-in vec4 vs_Nor;             // The array of vertex normals passed to the shader
-
+// Vertex shader for instanced rain. Like instanced.vert.glsl, every
+// instance is one copy of the mesh moved by vs_OffsetInstanced, which here
+// holds the x and z of a drop and the height it stops falling at.
+// The drop falls from FALL_ABOVE blocks over the camera down to that
+// height and starts over, each at its own point in the cycle.
+
+// Per-frame values shared by every shader, uploaded once per frame.
+// Must match FrameUniforms::Data in frameuniforms.h.
+layout(std140) uniform FrameUniforms {
+    mat4 u_ViewProj;    // The matrix that defines the camera's transformation.
+    mat4 u_ViewProjInv; // Its inverse, to turn screen points back into world space
+    vec4 u_Eye;         // Camera position, in xyz
+    int u_Time;         // Elapsed time in milliseconds
+    float u_TimeOfDay;  // Hours, from 0 to 24
+    float u_Weather;    // 0 for clear skies, up to 1 in a storm
+};
+
+in vec4 vs_Pos;             // Corner of the drop's sheet, with its bottom edge at y = 0
 in vec4 vs_UV;
+in vec3 vs_OffsetInstanced; // The drop's x and z, and the height it stops falling at
 
 out vec4 fs_Pos;
-out vec4 fs_Nor;            // The array of normals that has been transformed by u_ModelInvTr. This is implicitly passed to the fragment shader.
-out vec4 fs_LightVec;       // The direction in which our virtual light lies, relative to each vertex. This is implicitly passed to the fragment shader.
 out vec4 fs_UV;
 
-const vec4 lightDir = normalize(vec4(0.5, 1, 0.75, 0));  // The direction of our virtual light, which is used to compute the shading of
-                                        // the geometry in the fragment shader.
+const float FALL_ABOVE = 20.0; // Must match PRECIPITATION_ABOVE in precipitation.h
+const float FALL_SPEED = 12.0;  // Blocks per second
+
+// A pseudo-random value in [0, 1) for each drop
+float hash(vec2 p) {
+    return fract(sin(dot(p, vec2(12.9898, 78.233))) * 43758.5453);
+}
 
 void main()
 {
     fs_UV = vs_UV;
-    fs_Pos = vs_Pos;                   // Pass the vertex colors to the fragment shader for interpolation
-
-    mat3 invTranspose = mat3(u_ModelInvTr);
-    fs_Nor = vec4(invTranspose * vec3(vs_Nor), 0);          // Pass the vertex normals to the fragment shader for interpolation.
-                                                            // Transform the geometry's normals by the inverse transpose of the
-                                                            // model matrix. This is necessary to ensure the normals remain
-                                                            // perpendicular to the surface after the surface is transformed by
-                                                            // the model matrix.
-
 
-    vec4 modelposition = u_Model * vs_Pos;   // Temporarily store the transformed vertex positions for use below
+    float top = u_Eye.y + FALL_ABOVE;
+    float range = max(top - vs_OffsetInstanced.y, 1.0);
+    float fallen = mod(hash(vs_OffsetInstanced.xz) * range + float(u_Time) * 0.001 * FALL_SPEED, range);
+    vec3 base = vec3(vs_OffsetInstanced.x, top - fallen, vs_OffsetInstanced.z);
 
-    fs_LightVec = (lightDir);  // Compute the direction in which the light source lies
+    // Turn the sheet about the vertical to face the camera
+    vec2 toEye = u_Eye.xz - base.xz;
+    vec2 right = length(toEye) > 0.001 ? normalize(vec2(-toEye.y, toEye.x)) : vec2(1, 0);
+    vec4 worldPos = vec4(base.x + right.x * vs_Pos.x, base.y + vs_Pos.y, base.z + right.y * vs_Pos.x, 1);
 
-    gl_Position = u_ViewProj * modelposition;// gl_Position is a built-in variable of OpenGL which is
-                                             // used to render the final positions of the geometry's vertices
+    fs_Pos = worldPos;
+    gl_Position = u_ViewProj * worldPos;
 }
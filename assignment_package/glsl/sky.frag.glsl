@@ -1,19 +1,18 @@
 #version 150
 
-uniform mat4 u_ViewProj;    // We're actually passing the inverse of the viewproj
-                            // from our CPU, but it's named u_ViewProj so we don't
-                            // have to bother rewriting our ShaderProgram class
+// Per-frame values shared by every shader, uploaded once per frame.
+// Must match FrameUniforms::Data in frameuniforms.h.
+layout(std140) uniform FrameUniforms {
+    mat4 u_ViewProj;    // The matrix that defines the camera's transformation.
+    mat4 u_ViewProjInv; // Its inverse, to turn screen points back into world space
+    vec4 u_Eye;         // Camera position, in xyz
+    int u_Time;         // Elapsed time in milliseconds
+    float u_TimeOfDay;  // Hours, from 0 to 24
+    float u_Weather;    // 0 for clear skies, up to 1 in a storm
+};
 
 uniform ivec2 u_Dimensions; // Screen dimensions
 
-uniform vec3 u_Eye; // Camera pos
-
-uniform float u_Time;
-uniform float u_TimeOfDay;
-
-uniform float u_Weather;
-
-
 out vec4 outColor;
 const float PI = 3.14159265359;
 const float TWO_PI = 6.28318530718;
@@ -227,7 +226,7 @@ float WorleyNoise3D(vec3 p)
                 vec3 point = random3(pointInt + neighbor);
 
                 // Animate the point
-                point = 0.5 + 0.5 * sin(u_Time * 0.01 + 6.2831 * point); // 0 to 1 range
+                point = 0.5 + 0.5 * sin(float(u_Time) * 0.01 + 6.2831 * point); // 0 to 1 range
 
                 // Compute the distance b/t the point and the fragment
                 // Store the min dist thus far
@@ -259,7 +258,7 @@ float WorleyNoise(vec2 uv)
             vec2 point = random2(uvInt + neighbor);
 
             // Animate the point
-            point = 0.5 + 0.5 * sin(u_Time * 0.005 + 6.2831 * point); // 0 to 1 range
+            point = 0.5 + 0.5 * sin(float(u_Time) * 0.005 + 6.2831 * point); // 0 to 1 range
 
             // Compute the distance b/t the point and the fragment
             // Store the min dist thus far
@@ -295,9 +294,9 @@ void main()
 
     vec4 p = vec4(ndc.xy, 1, 1); // Pixel at the far clip plane
     p *= 10000.0; // Times far clip plane value
-    p = /*Inverse of*/ u_ViewProj * p; // Convert from unhomogenized screen to world
+    p = u_ViewProjInv * p; // Convert from unhomogenized screen to world
 
-    vec3 rayDir = normalize(p.xyz - u_Eye);
+    vec3 rayDir = normalize(p.xyz - u_Eye.xyz);
 
 #ifdef RAY_AS_COLOR
     outColor = 0.5 * (rayDir + vec3(1,1,1));
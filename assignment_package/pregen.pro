@@ -0,0 +1,27 @@
+# Headless world pregeneration: generates a region of the world on a thread
+# pool without opening a window, reports throughput, and can save the blocks.
+#   pregen --region -256,-256,256,256 --threads 8 --out world/
+QT += core
+QT -= gui
+
+TARGET = pregen
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += c++1z
+CONFIG += release
+
+INCLUDEPATH += include
+
+include(src/generation.pri)
+
+# the culling math --verify checks
+SOURCES += src/scene/frustum.cpp
+HEADERS += src/scene/frustum.h
+
+SOURCES += tools/pregen.cpp
+
+*-clang*|*-g++* {
+    QMAKE_CXXFLAGS += -Wall -Wextra -pedantic -Winit-self
+    QMAKE_CXXFLAGS += -Wno-strict-aliasing
+}
@@ -2,6 +2,12 @@
 #include <openglcontext.h>
 #include <glm_includes.h>
 
+// Attribute locations every ShaderProgram is linked with, so that a vertex
+// array object set up once works with any program that draws from it
+#define ATTR_POS_LOCATION 0
+#define ATTR_NOR_LOCATION 1
+#define ATTR_UV_LOCATION 2
+
 //This defines a class which can be rendered by our shader program.
 //Make any geometry a subclass of ShaderProgram::Drawable in order to render it with the ShaderProgram class.
 class Drawable
@@ -37,7 +43,7 @@ public:
     virtual ~Drawable();
 
     virtual void createVBOdata() = 0; // To be implemented by subclasses. Populates the VBOs of the Drawable.
-    void destroyVBOdata(); // Frees the VBOs of the Drawable.
+    virtual void destroyVBOdata(); // Frees the VBOs of the Drawable.
 
     // Getter functions for various GL data
     virtual GLenum drawMode();
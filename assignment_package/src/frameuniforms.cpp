@@ -0,0 +1,27 @@
+#include "frameuniforms.h"
+
+FrameUniforms::FrameUniforms(OpenGLContext *context)
+    : mp_context(context), m_buffer(-1), m_created(false)
+{}
+
+void FrameUniforms::create() {
+    mp_context->glGenBuffers(1, &m_buffer);
+    mp_context->glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+    // Reserve the space now; upload() rewrites all of it every frame
+    mp_context->glBufferData(GL_UNIFORM_BUFFER, sizeof(Data), nullptr, GL_DYNAMIC_DRAW);
+    // The buffer stays attached to this binding point for the life of the context
+    mp_context->glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, m_buffer);
+    m_created = true;
+}
+
+void FrameUniforms::destroy() {
+    if(m_created) {
+        m_created = false;
+        mp_context->glDeleteBuffers(1, &m_buffer);
+    }
+}
+
+void FrameUniforms::upload(const Data &data) {
+    mp_context->glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+    mp_context->glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Data), &data);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "openglcontext.h"
+#include "glm_includes.h"
+
+// The uniform buffer binding point every shader's FrameUniforms block reads from
+#define FRAME_UNIFORMS_BINDING 0
+
+// A class representing the uniform buffer that holds the values every
+// shader needs once per frame: the camera, the clock and the weather.
+// ShaderProgram::create points each program's FrameUniforms block at
+// FRAME_UNIFORMS_BINDING, so a single upload() at the start of paintGL
+// reaches all of them instead of setting each uniform on each program.
+class FrameUniforms {
+public:
+    // Laid out to match the std140 FrameUniforms block in the shaders;
+    // keep the two in sync.
+    struct Data {
+        glm::mat4 viewProj;
+        glm::mat4 viewProjInv;
+        glm::vec4 eye;
+        GLint time;        // Elapsed time in milliseconds
+        float timeOfDay;   // Hours, from 0 to 24
+        float weather;     // 0 for clear skies, up to 1 in a storm
+        float padding;     // Rounds the block up to a whole vec4
+    };
+
+private:
+    OpenGLContext *mp_context;
+    GLuint m_buffer;
+    bool m_created;
+
+public:
+    FrameUniforms(OpenGLContext *context);
+    // Allocate the buffer on the GPU and attach it to FRAME_UNIFORMS_BINDING
+    void create();
+    // Deallocate all GPU-side data
+    void destroy();
+    // Overwrite the buffer's contents with this frame's values
+    void upload(const Data &data);
+};
@@ -0,0 +1,41 @@
+# The terrain generation code: chunks, noise, climate, caves and structures.
+# It needs no window, GL context or Qt GUI module, so the headless tools
+# link it without the rest of the game. Buffering chunks' meshes is in
+# src.pri, with the chunk arena and the rest of the GL code.
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += \
+    $$PWD/noise.cpp \
+    $$PWD/noiselayer.cpp \
+    $$PWD/scene/chunk.cpp \
+    $$PWD/scene/arenaallocator.cpp \
+    $$PWD/scene/climatemap.cpp \
+    $$PWD/scene/cavefield.cpp \
+    $$PWD/scene/structureregistry.cpp \
+    $$PWD/scene/workers.cpp \
+    $$PWD/scene/structuredata/icespike.cpp \
+    $$PWD/scene/structuredata/lookout.cpp \
+    $$PWD/scene/structuredata/pyramid.cpp \
+    $$PWD/scene/structuredata/stencil.cpp \
+    $$PWD/scene/structuredata/structure.cpp \
+    $$PWD/scene/structuredata/tree.cpp
+
+HEADERS += \
+    $$PWD/noise.h \
+    $$PWD/noiselayer.h \
+    $$PWD/smartpointerhelp.h \
+    $$PWD/glm_includes.h \
+    $$PWD/scene/chunk.h \
+    $$PWD/scene/arenaallocator.h \
+    $$PWD/scene/climatemap.h \
+    $$PWD/scene/cavefield.h \
+    $$PWD/scene/structureregistry.h \
+    $$PWD/scene/workers.h \
+    $$PWD/scene/structuredata/icespike.h \
+    $$PWD/scene/structuredata/lookout.h \
+    $$PWD/scene/structuredata/pyramid.h \
+    $$PWD/scene/structuredata/stencil.h \
+    $$PWD/scene/structuredata/structure.h \
+    $$PWD/scene/structuredata/tree.h
@@ -0,0 +1,63 @@
+#include "gpuframetimer.h"
+
+GpuFrameTimer::GpuFrameTimer(OpenGLContext *context)
+    : mp_context(context), m_queries(), m_pending(), m_next(0), m_timing(false), m_created(false), m_lastMs(0.f)
+{}
+
+void GpuFrameTimer::create() {
+    mp_context->glGenQueries(GPU_TIMER_QUERIES, m_queries.data());
+    m_pending.fill(false);
+    m_next = 0;
+    m_created = true;
+}
+
+void GpuFrameTimer::destroy() {
+    if(m_created) {
+        m_created = false;
+        mp_context->glDeleteQueries(GPU_TIMER_QUERIES, m_queries.data());
+    }
+}
+
+void GpuFrameTimer::collect() {
+    for (int i = 0; i < GPU_TIMER_QUERIES; ++i) {
+        int slot = (m_next + i) % GPU_TIMER_QUERIES;
+        if (!m_pending[slot]) {
+            continue;
+        }
+        GLuint available = 0;
+        mp_context->glGetQueryObjectuiv(m_queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        // Queries finish in the order they were issued, so none after this one have either
+        if (!available) {
+            return;
+        }
+        GLuint ns = 0;
+        mp_context->glGetQueryObjectuiv(m_queries[slot], GL_QUERY_RESULT, &ns);
+        m_lastMs = ns * 1e-6f;
+        m_pending[slot] = false;
+    }
+}
+
+void GpuFrameTimer::begin() {
+    if (!m_created) {
+        return;
+    }
+    collect();
+    m_timing = !m_pending[m_next];
+    if (m_timing) {
+        mp_context->glBeginQuery(GL_TIME_ELAPSED, m_queries[m_next]);
+    }
+}
+
+void GpuFrameTimer::end() {
+    if (!m_timing) {
+        return;
+    }
+    mp_context->glEndQuery(GL_TIME_ELAPSED);
+    m_pending[m_next] = true;
+    m_next = (m_next + 1) % GPU_TIMER_QUERIES;
+    m_timing = false;
+}
+
+float GpuFrameTimer::lastMs() const {
+    return m_lastMs;
+}
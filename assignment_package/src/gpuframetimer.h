@@ -0,0 +1,41 @@
+#pragma once
+#include "openglcontext.h"
+#include <array>
+
+// How many frames' timer queries can be in flight at once. The GPU runs a
+// frame or two behind the CPU, so results are read a few frames late.
+#define GPU_TIMER_QUERIES 4
+
+// A class that measures how long the GPU spends on each frame's commands
+// with GL_TIME_ELAPSED queries. Results are only collected once the GPU
+// has finished with them, so timing never stalls the pipeline; a frame
+// whose query slot is still in flight simply goes untimed.
+class GpuFrameTimer {
+private:
+    OpenGLContext *mp_context;
+    std::array<GLuint, GPU_TIMER_QUERIES> m_queries;
+    // Has this query been issued without its result being read yet?
+    std::array<bool, GPU_TIMER_QUERIES> m_pending;
+    // The query the next frame uses; the oldest in-flight one comes after it
+    int m_next;
+    // Is a query running between begin() and end()?
+    bool m_timing;
+    bool m_created;
+    float m_lastMs;
+
+    // Reads every finished query, oldest first, without waiting on the GPU
+    void collect();
+
+public:
+    GpuFrameTimer(OpenGLContext *context);
+    // Allocate the queries on the GPU
+    void create();
+    // Deallocate all GPU-side data
+    void destroy();
+    // Bracket one frame's GL commands
+    void begin();
+    void end();
+    // GPU time of the most recent frame whose result has come back,
+    // in milliseconds. 0 until the first one does.
+    float lastMs() const;
+};
@@ -1,4 +1,6 @@
 #include <mainwindow.h>
+#include "noise.h"
+#include "scene/cavefield.h"
 
 #include <QApplication>
 #include <QSurfaceFormat>
@@ -37,6 +39,26 @@ int main(int argc, char *argv[])
     QSurfaceFormat::setDefaultFormat(format);
     debugFormatVersion();
 
+    // "--seed <n>" generates a seeded world with the integer-hash noise.
+    // Without it we keep the original sin-hash world.
+    QStringList args = a.arguments();
+    int seedArg = args.indexOf("--seed");
+    if (seedArg != -1 && seedArg + 1 < args.size()) {
+        Noise::setBackend(Noise::Backend::INT_HASH, args[seedArg + 1].toUInt());
+    }
+
+    // "--caves refined" or "--caves fast" interpolates the cave noise
+    // from a coarse lattice instead of evaluating it at every block
+    int cavesArg = args.indexOf("--caves");
+    if (cavesArg != -1 && cavesArg + 1 < args.size()) {
+        const QString &quality = args[cavesArg + 1];
+        if (quality == "refined") {
+            CaveField::setQuality(CaveField::REFINED);
+        } else if (quality == "fast") {
+            CaveField::setQuality(CaveField::FAST);
+        }
+    }
+
     MainWindow w;
     w.show();
 
@@ -18,6 +18,10 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->mygl, SIGNAL(sig_sendPlayerLook(QString)), &playerInfoWindow, SLOT(slot_setLookText(QString)));
     connect(ui->mygl, SIGNAL(sig_sendPlayerChunk(QString)), &playerInfoWindow, SLOT(slot_setChunkText(QString)));
     connect(ui->mygl, SIGNAL(sig_sendPlayerTerrainZone(QString)), &playerInfoWindow, SLOT(slot_setZoneText(QString)));
+    connect(ui->mygl, SIGNAL(sig_sendDrawStats(QString)), &playerInfoWindow, SLOT(slot_setDrawStatsText(QString)));
+    connect(ui->mygl, SIGNAL(sig_sendArenaStats(QString)), &playerInfoWindow, SLOT(slot_setArenaStatsText(QString)));
+    connect(ui->mygl, SIGNAL(sig_sendRenderDistance(QString)), &playerInfoWindow, SLOT(slot_setRenderDistanceText(QString)));
+    connect(ui->mygl, SIGNAL(sig_sendWeatherStats(QString)), &playerInfoWindow, SLOT(slot_setWeatherStatsText(QString)));
 }
 
 MainWindow::~MainWindow()
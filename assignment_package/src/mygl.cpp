@@ -13,10 +13,12 @@
 MyGL::MyGL(QWidget *parent)
     : OpenGLContext(parent),
       m_quad(this),
-      m_geomQuad(new Quad(this)), m_rainPlane(this), m_progLambert(this), m_progFlat(this), m_progInstanced(this),
+      m_geomQuad(new Quad(this)), m_precipitation(this), m_progLambert(this), m_progFlat(this), m_progInstanced(this),
       m_progRain(this), m_progSky(this), m_progSnow(this), m_progRainPlane(this), m_progSnowPlane(this), m_blockShaders(),
-      m_frameBuffer(this, this->width(), this->height(), this->devicePixelRatio()), m_terrain(this),
+      m_frameBuffer(this, this->width(), this->height(), this->devicePixelRatio()), m_frameUniforms(this),
+      m_terrain(this),
       m_player(glm::vec3(0, 175, 0), m_terrain),
+      m_renderDistance(), m_frameTimer(), m_gpuTimer(this), m_tickMs(0.f),
       lastTickTime(QDateTime::currentMSecsSinceEpoch()), elapsedTime(0), timeOfDay(0.f), pastWeather(0)
 {
     // Connect the timer to a function so that when the timer ticks the function is executed
@@ -32,6 +34,8 @@ MyGL::MyGL(QWidget *parent)
 MyGL::~MyGL() {
     makeCurrent();
     glDeleteVertexArrays(1, &vao);
+    m_frameUniforms.destroy();
+    m_gpuTimer.destroy();
 }
 
 
@@ -44,6 +48,7 @@ void MyGL::initializeGL()
     // Create an OpenGL context using Qt's QOpenGLFunctions_3_2_Core class
     // If you were programming in a non-Qt context you might use GLEW (GL Extension Wrangler)instead
     initializeOpenGLFunctions();
+    initializeMultiDraw();
     // Print out some information about the current OpenGL context
     debugContextVersion();
 
@@ -64,11 +69,15 @@ void MyGL::initializeGL()
 
     // Initializes frame buffer on the GPU
     m_frameBuffer.create();
+    // Initializes the per-frame uniform buffer every shader reads from
+    m_frameUniforms.create();
+    // Initializes the queries that time each frame on the GPU
+    m_gpuTimer.create();
 
     //Create Quad instance
     m_quad.createVBOdata();
-    //Create rainPlane data
-    m_rainPlane.createVBOdata();
+    //Create the precipitation drop mesh
+    m_precipitation.createVBOdata();
 
     // Create and set up the diffuse shader
     m_progLambert.create(":/glsl/lambert.vert.glsl", ":/glsl/lambert.frag.glsl");
@@ -114,7 +123,9 @@ void MyGL::initializeGL()
     // We have to have a VAO bound in OpenGL 3.2 Core. But if we're not
     // using multiple VAOs, we can just bind one once.
     glBindVertexArray(vao);
-    m_terrain.initializeNearbyChunks(0, 0, 3, true);
+    // Generate the world around the player on the worker threads; chunks
+    // show up as they are buffered, starting with the spawn chunk
+    m_terrain.loadSpawnArea(m_player.mcr_position);
     //m_terrain.CreateTestScene();
 }
 
@@ -122,30 +133,10 @@ void MyGL::resizeGL(int w, int h) {
     //This code sets the concatenated view and perspective projection matrices used for
     //our scene's camera view.
     m_player.setCameraWidthHeight(static_cast<unsigned int>(w), static_cast<unsigned int>(h));
-    glm::mat4 viewproj = m_player.mcr_camera.getViewProj();
-
-    // Upload the view-projection matrix to our shaders (i.e. onto the graphics card)
-
-    m_progLambert.setViewProjMatrix(viewproj);
-    m_progFlat.setViewProjMatrix(viewproj);
-    m_progInstanced.setViewProjMatrix(viewproj);
-    m_progRain.setViewProjMatrix(viewproj);
-    m_progSnow.setViewProjMatrix(viewproj);
-    m_progSky.setViewProjMatrix(glm::inverse(viewproj));
-
+    // The new view-projection matrix reaches the shaders with the next
+    // frame's uniform upload; only the sky needs the screen size
     m_progSky.useMe();
     this->glUniform2i(m_progSky.unifDimensions, width(), height());
-    this->glUniform3f(m_progSky.unifEye, m_player.mcr_camera.mcr_position.x, m_player.mcr_camera.mcr_position.y, m_player.mcr_camera.mcr_position.z);
-    this->glUniform1f(m_progSky.unifWeather, pastWeather.x);
-
-    m_progRainPlane.useMe();
-    this->glUniform1f(m_progRainPlane.unifWeather, pastWeather.x);
-
-    m_progSnowPlane.useMe();
-    this->glUniform1f(m_progSnowPlane.unifWeather, pastWeather.x);
-
-    m_progRain.useMe();
-    this->glUniform1f(m_progRain.unifWeather, pastWeather.x);
 
     m_frameBuffer.resize(w, h, this->devicePixelRatio());
     m_frameBuffer.create();
@@ -159,11 +150,15 @@ void MyGL::resizeGL(int w, int h) {
 // all per-frame actions here, such as performing physics updates on all
 // entities in the scene.
 void MyGL::tick() {
+    m_frameTimer.start();
     int dtMillis = (int) glm::clamp((QDateTime::currentMSecsSinceEpoch() - lastTickTime) * 1.f, 0.f, 100.f);
     float dt = dtMillis * 0.001f;
 
     elapsedTime += dtMillis;
-    m_player.tick(dt, m_inputs);
+    // Hold the player in place until there is ground all around them
+    if (m_terrain.spawnNeighborhoodGenerated()) {
+        m_player.tick(dt, m_inputs);
+    }
     lastTickTime = QDateTime::currentMSecsSinceEpoch();
 
     timeOfDay = glm::mod(timeOfDay + dt / 6.f, 24.f);
@@ -192,6 +187,7 @@ void MyGL::tick() {
 
     pastWeather.x = glm::clamp((pastWeather.x + 0.01f * (pastWeather.y - 0.5f)), 0.f, 1.f);
 
+    m_tickMs = m_frameTimer.nsecsElapsed() * 1e-6f;
     update(); // Calls paintGL() as part of a larger QOpenGLWidget pipeline
     sendPlayerDataToGUI(); // Updates the info in the secondary window displaying player data
 }
@@ -215,12 +211,44 @@ void MyGL::sendPlayerDataToGUI() const {
     glm::ivec2 zone(64 * glm::ivec2(glm::floor(pPos / 64.f)));
     emit sig_sendPlayerChunk(QString::fromStdString("( " + std::to_string(chunk.x) + ", " + std::to_string(chunk.y) + " )"));
     emit sig_sendPlayerTerrainZone(QString::fromStdString("( " + std::to_string(zone.x) + ", " + std::to_string(zone.y) + " )"));
+    const TerrainDrawStats &stats = m_terrain.getDrawStats();
+    emit sig_sendDrawStats(QString::fromStdString(std::to_string(stats.drawn) + " drawn, " + std::to_string(stats.culled) +
+                                                  " culled, " + std::to_string(stats.occluded) +
+                                                  " occluded of " + std::to_string(stats.considered) +
+                                                  " in " + QString::number(stats.cpuMs, 'f', 2).toStdString() + " ms, " +
+                                                  QString::number(stats.sortMs, 'f', 2).toStdString() + " ms sorting"));
+    ChunkArenaStats arena = m_terrain.getArenaStats();
+    emit sig_sendArenaStats(QString::fromStdString(std::to_string(arena.meshes) + " meshes, " +
+                                                   std::to_string(100 * arena.verticesUsed / std::max(arena.vertexCapacity, 1u)) +
+                                                   "% of " + std::to_string(arena.vertexCapacity / 1024) + "k vertices, " +
+                                                   std::to_string(100 * arena.indicesUsed / std::max(arena.indexCapacity, 1u)) +
+                                                   "% of " + std::to_string(arena.indexCapacity / 1024) + "k indices, " +
+                                                   std::to_string(arena.vertexFreeBlocks) + " free blocks, " +
+                                                   QString::number(100 * arena.vertexFragmentation, 'f', 1).toStdString() +
+                                                   "% fragmented, grown " + std::to_string(arena.grows) + " times"));
+    emit sig_sendRenderDistance(QString::fromStdString(std::to_string(m_renderDistance.radius()) + " chunks, frame p50 " +
+                                                       QString::number(m_renderDistance.framePercentile(0.5f), 'f', 2).toStdString() + " / p95 " +
+                                                       QString::number(m_renderDistance.framePercentile(0.95f), 'f', 2).toStdString() + " / p99 " +
+                                                       QString::number(m_renderDistance.framePercentile(0.99f), 'f', 2).toStdString() +
+                                                       " ms, upload p95 " +
+                                                       QString::number(m_renderDistance.uploadPercentile(0.95f), 'f', 2).toStdString() + " ms"));
+    if (pastWeather.x != 0) {
+        const PrecipitationStats &weather = m_precipitation.getStats();
+        emit sig_sendWeatherStats(QString::fromStdString(std::to_string(weather.drops) + " drops in " +
+                                                         std::to_string(weather.drawCalls) + " draw call(s), " +
+                                                         std::to_string(weather.covered) + " of " + std::to_string(weather.columns) +
+                                                         " columns covered"));
+    } else {
+        emit sig_sendWeatherStats("Clear");
+    }
 }
 
 // This function is called whenever update() is called.
 // MyGL's constructor links update() to a timer that fires 60 times per second,
 // so paintGL() called at a rate of 60 frames per second.
 void MyGL::paintGL() {
+    m_frameTimer.start();
+    m_gpuTimer.begin();
     // normal 3d rendering to buffer pipeline
     m_frameBuffer.bindFrameBuffer();
     glViewport(0, 0, this->width() * this->devicePixelRatio(), this->height() * this->devicePixelRatio());
@@ -232,43 +260,10 @@ void MyGL::paintGL() {
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    glm::mat4 viewproj = m_player.mcr_camera.getViewProj();
-
     glEnable(GL_DEPTH_TEST);
 
-    // set sky shader in variables
-    m_progSky.useMe();
-    m_progSky.setViewProjMatrix(glm::inverse(viewproj));
-    m_progSky.setTimeOfDay(timeOfDay);
-    this->glUniform3f(m_progSky.unifEye, m_player.mcr_camera.mcr_position.x, m_player.mcr_camera.mcr_position.y, m_player.mcr_camera.mcr_position.z);
-    this->glUniform1f(m_progSky.unifTime, elapsedTime);
-    this->glUniform1f(m_progSky.unifWeather, pastWeather.x);
-
-    // set rain and show plane variables
-    m_progRainPlane.useMe();
-    this->glUniform1f(m_progRainPlane.unifWeather, pastWeather.x);
-    m_progSnowPlane.useMe();
-    this->glUniform1f(m_progSnowPlane.unifWeather, pastWeather.x);
-
-    // set rain and snow post shader variables
-    m_progRain.useMe();
-    this->glUniform1f(m_progRain.unifWeather, pastWeather.x);
-    m_progSnow.useMe();
-    this->glUniform1f(m_progSnow.unifWeather, pastWeather.x);
-
-    m_progFlat.setViewProjMatrix(m_player.mcr_camera.getViewProj());
-    m_progLambert.setViewProjMatrix(m_player.mcr_camera.getViewProj());
-    m_progInstanced.setViewProjMatrix(m_player.mcr_camera.getViewProj());
-    m_progRain.setViewProjMatrix(m_player.mcr_camera.getViewProj());
-    m_progSnow.setViewProjMatrix(m_player.mcr_camera.getViewProj());
-
-    m_progLambert.setTime(elapsedTime);
-    m_progFlat.setTime(elapsedTime);
-    m_progRain.setTime(elapsedTime);
-    m_progSnow.setTime(elapsedTime);
-
-    m_progLambert.setTimeOfDay(timeOfDay);
-    this->glUniform1f(m_progLambert.unifWeather, pastWeather.x);
+    // camera, time and weather for every shader, sky to post-process
+    uploadFrameUniforms();
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -280,17 +275,21 @@ void MyGL::paintGL() {
     // terrain
     renderTerrain();
 
-    // weather planes
+    // rain or snow, all drops in one draw. They are blended, so they
+    // don't write depth and hide the drops behind them.
     if (pastWeather.x != 0) {
+        m_precipitation.update(m_terrain, m_player.mcr_camera.mcr_position);
+        bool snowing = m_player.mcr_position.y >= SNOW_HEIGHT;
         glDisable(GL_CULL_FACE);
-        m_rainPlane.drawPlanes(&m_progRain, &m_progSnow, &m_player);
+        glDepthMask(GL_FALSE);
+        m_precipitation.draw(snowing ? &m_progSnow : &m_progRain, snowing ? 2 : 1);
+        glDepthMask(GL_TRUE);
         glEnable(GL_CULL_FACE);
     }
 
     // world axes
     glDisable(GL_DEPTH_TEST);
     m_progFlat.setModelMatrix(glm::mat4());
-    m_progFlat.setViewProjMatrix(m_player.mcr_camera.getViewProj());
     //m_progFlat.draw(m_worldAxes);
     glEnable(GL_DEPTH_TEST);
 
@@ -300,10 +299,12 @@ void MyGL::paintGL() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     m_frameBuffer.bindToTextureSlot(POST_TEXTURE_SLOT);
 
-    // get post shader based on block we're inside of
-    ShaderProgram* postShader = getPostShader(m_terrain.getBlockAt(m_player.mcr_camera.mcr_position));
+    // get post shader based on block we're inside of,
+    // treating an unloaded chunk as empty space
+    BlockType cameraBlock = m_terrain.queryBlockAt(m_player.mcr_camera.mcr_position).value_or(EMPTY);
+    ShaderProgram* postShader = getPostShader(cameraBlock);
 
-    if (m_terrain.getBlockAt(m_player.mcr_camera.mcr_position) == EMPTY && pastWeather.x != 0) {
+    if (cameraBlock == EMPTY && pastWeather.x != 0) {
         if (m_player.mcr_position.y >= SNOW_HEIGHT) {
             postShader = &m_progSnowPlane;
         } else {
@@ -311,14 +312,40 @@ void MyGL::paintGL() {
         }
     }
     // draw post shader
-    postShader->setTime(elapsedTime);
     postShader->drawPostShader(m_quad, m_frameBuffer.getTextureSlot());
+
+    m_gpuTimer.end();
+
+    // The startup load's uploads would only tell us how fast loading is
+    if (m_terrain.spawnAreaLoaded()) {
+        // The CPU and GPU work on different frames at once, so a frame
+        // takes as long as the slower of the two
+        float frameMs = glm::max(m_tickMs + m_frameTimer.nsecsElapsed() * 1e-6f, m_gpuTimer.lastMs());
+        if (m_renderDistance.addFrame(frameMs, m_terrain.getUploadMs())) {
+            m_terrain.setCreateRadius(m_renderDistance.zoneRadius());
+        }
+    }
+}
+
+void MyGL::uploadFrameUniforms() {
+    FrameUniforms::Data data;
+    data.viewProj = m_player.mcr_camera.getViewProj();
+    data.viewProjInv = glm::inverse(data.viewProj);
+    data.eye = glm::vec4(m_player.mcr_camera.mcr_position, 1.f);
+    data.time = elapsedTime;
+    data.timeOfDay = timeOfDay;
+    data.weather = pastWeather.x;
+    data.padding = 0.f;
+    m_frameUniforms.upload(data);
 }
 
 void MyGL::renderTerrain() {
     auto& pos = m_player.mcr_camera.mcr_position;
-    int radius = Chunk::WIDTH * 24;
-    m_terrain.draw(pos.x - radius, pos.x + radius, pos.z - radius, pos.z + radius, &m_progLambert);
+    int radius = Chunk::WIDTH * m_renderDistance.radius();
+    Frustum frustum(m_player.mcr_camera.getViewProj());
+    m_terrain.draw(pos.x - radius, pos.x + radius, pos.z - radius, pos.z + radius, frustum, pos, &m_progLambert);
+    // Chunks draw from the arena's VAO; everything else shares ours
+    glBindVertexArray(vao);
 }
 
 void MyGL::keyPressEvent(QKeyEvent *e) {
@@ -419,7 +446,8 @@ void MyGL::mousePressEvent(QMouseEvent *e) {
                 }
             }
             if(interfaceAxis == -1) {
-                throw std::out_of_range("interfaceAxis was -1 after the for loop in gridMarch!");
+                // no axis to step along, so there is nothing to hit
+                break;
             }
             curr_t += min_t; // min_t is declared in slide 7 algorithm
             rayOrigin += rayDirection * min_t;
@@ -432,10 +460,15 @@ void MyGL::mousePressEvent(QMouseEvent *e) {
                 // curr_t
                 //std::cout << "rayOrigin: " << rayOrigin.x << " " << rayOrigin.y << " " << rayOrigin.z << std::endl ;
                 //std::cout << "currCell: " << currCell.x << " " << currCell.y << " " << currCell.z << std::endl ;
-                BlockType cellType = m_terrain.getBlockAt(currCell.x, currCell.y, currCell.z);
-                if(cellType != EMPTY) {
-                    m_terrain.setBlockAt(currCell.x, currCell.y, currCell.z, EMPTY) ;
-                    m_terrain.getChunkAt(currCell.x, currCell.z)->createVBOdata() ;
+                std::optional<BlockType> cellType = m_terrain.queryBlockAt(currCell.x, currCell.y, currCell.z);
+                // stop at the edge of the loaded world
+                if(!cellType.has_value()) {
+                    break;
+                }
+                if(*cellType != EMPTY) {
+                    BlockEditBatch edit;
+                    edit.setBlockAt(currCell.x, currCell.y, currCell.z, EMPTY);
+                    m_terrain.commitEdits(edit);
                     break;
                 }
             }
@@ -467,7 +500,8 @@ void MyGL::mousePressEvent(QMouseEvent *e) {
                 }
             }
             if(interfaceAxis == -1) {
-                throw std::out_of_range("interfaceAxis was -1 after the for loop in gridMarch!");
+                // no axis to step along, so there is nothing to hit
+                break;
             }
             curr_t += min_t; // min_t is declared in slide 7 algorithm
             rayOrigin += rayDirection * min_t;
@@ -480,8 +514,12 @@ void MyGL::mousePressEvent(QMouseEvent *e) {
                 // curr_t
                 //std::cout << "rayOrigin: " << rayOrigin.x << " " << rayOrigin.y << " " << rayOrigin.z << std::endl ;
                 //std::cout << "currCell: " << currCell.x << " " << currCell.y << " " << currCell.z << std::endl ;
-                BlockType cellType = m_terrain.getBlockAt(currCell.x, currCell.y, currCell.z);
-                if(cellType != EMPTY) {
+                std::optional<BlockType> cellType = m_terrain.queryBlockAt(currCell.x, currCell.y, currCell.z);
+                // stop at the edge of the loaded world
+                if(!cellType.has_value()) {
+                    break;
+                }
+                if(*cellType != EMPTY) {
                     float outDist = glm::min(maxLen, curr_t) ;
                     glm::vec3 intersect = m_player.mcr_camera.mcr_position + outDist * m_player.getForward() ;
                     glm::vec3 center = glm::vec3(currCell.x + 0.5f, currCell.y + 0.5f, currCell.z + 0.5f) ;
@@ -493,8 +531,10 @@ void MyGL::mousePressEvent(QMouseEvent *e) {
                     } else if (offset.z > offset.y && offset.z > offset.x) {
                         currCell.x += glm::sign(offset.z) ;
                     }
-                    m_terrain.setBlockAt(currCell.x, currCell.y, currCell.z, GRASS) ;
-                    m_terrain.getChunkAt(currCell.x, currCell.z)->createVBOdata() ;
+                    // commitEdits skips the block if it lands outside the loaded world
+                    BlockEditBatch edit;
+                    edit.setBlockAt(currCell.x, currCell.y, currCell.z, GRASS);
+                    m_terrain.commitEdits(edit);
                     break;
                 }
             }
@@ -4,6 +4,10 @@
 #include "openglcontext.h"
 #include "shaderprogram.h"
 #include "framebuffer.h"
+#include "frameuniforms.h"
+#include "gpuframetimer.h"
+#include "renderdistance.h"
+#include "texture.h"
 #include "scene/quad.h"
 #include "scene/worldaxes.h"
 #include "scene/camera.h"
@@ -11,12 +15,13 @@
 #include "scene/terrain.h"
 #include "scene/player.h"
 #include <QDateTime>
+#include <QElapsedTimer>
 
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLShaderProgram>
 #include <smartpointerhelp.h>
 
-#include <scene/raindrop.h>
+#include <scene/precipitation.h>
 
 
 class MyGL : public OpenGLContext
@@ -25,12 +30,12 @@ class MyGL : public OpenGLContext
 private:
     Quad m_quad;            // A simple drawable mesh used for post-processing
     Quad* m_geomQuad;
-    Raindrop m_rainPlane;
+    Precipitation m_precipitation; // Rain or snow drops around the camera, drawn instanced
 
     ShaderProgram m_progLambert;    // A shader program that uses lambertian reflection
     ShaderProgram m_progFlat;       // A shader program that uses "flat" reflection (no shadowing at all)
     ShaderProgram m_progInstanced;  // A shader program that is designed to be compatible with instanced rendering
-    ShaderProgram m_progRain;  // A shader program that is designed to be compatible with instanced rendering
+    ShaderProgram m_progRain;  // Instanced shader programs that move precipitation drops as they fall
     ShaderProgram m_progSky;
     ShaderProgram m_progSnow;
     ShaderProgram m_progRainPlane;
@@ -38,6 +43,7 @@ private:
 
     std::unordered_map<BlockType, uPtr<ShaderProgram>> m_blockShaders; // Post-processing shaders for when the player is inside some block
     FrameBuffer m_frameBuffer;  // A frame buffer that allow us to apply post-processing shaders
+    FrameUniforms m_frameUniforms; // Camera, time and weather values shared by every shader program
 
     GLuint vao; // A handle for our vertex array object. This will store the VBOs created in our geometry classes.
                 // Don't worry too much about this. Just know it is necessary in order to render geometry.
@@ -48,6 +54,11 @@ private:
 
     QTimer m_timer;  // Timer linked to tick(). Fires approximately 60 times per second.
 
+    RenderDistance m_renderDistance; // Picks the draw and generation radii from frame times
+    QElapsedTimer m_frameTimer;      // Times tick() and paintGL()
+    GpuFrameTimer m_gpuTimer;        // Times the GL commands paintGL() issues
+    float m_tickMs;                  // CPU time the last tick() took, in milliseconds
+
     std::unique_ptr<Texture> mp_texture;
     std::unique_ptr<Texture> mp_texture2;
     std::unique_ptr<Texture> mp_texture3;
@@ -57,6 +68,8 @@ private:
                                // your mouse stays within the screen bounds and is always read.
 
     ShaderProgram* getPostShader(BlockType block);
+    // Refill m_frameUniforms from the camera, clock and weather
+    void uploadFrameUniforms();
 
     void sendPlayerDataToGUI() const;
 
@@ -111,6 +124,10 @@ signals:
     void sig_sendPlayerLook(QString) const;
     void sig_sendPlayerChunk(QString) const;
     void sig_sendPlayerTerrainZone(QString) const;
+    void sig_sendDrawStats(QString) const;
+    void sig_sendArenaStats(QString) const;
+    void sig_sendRenderDistance(QString) const;
+    void sig_sendWeatherStats(QString) const;
 };
 
 
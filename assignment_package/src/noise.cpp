@@ -1,15 +1,77 @@
 #include "noise.h"
 
+#include <algorithm>
 #include <array>
+#include <cstring>
 
 
-float Noise::rand(glm::vec2 co) { return glm::fract(sin(glm::dot(co ,glm::vec2(12.9898,78.233))) * 43758.5453); }
+static Noise::Backend currentBackend = Noise::Backend::SIN_HASH;
+static uint32_t worldSeed = 0;
+
+void Noise::setBackend(Backend b, uint32_t s) {
+    currentBackend = b;
+    worldSeed = s;
+}
+
+Noise::Backend Noise::getBackend() { return currentBackend; }
+uint32_t Noise::getSeed() { return worldSeed; }
+
+// the bits of a float coordinate, with -0 folded into +0
+static uint32_t coordBits(float v) {
+    v += 0.f;
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+// PCG-style output permutation: every input bit affects every output bit
+static uint32_t hashMix(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x7feb352dU;
+    h ^= h >> 15;
+    h *= 0x846ca68bU;
+    h ^= h >> 16;
+    return h;
+}
+
+// Each function folds its coordinates into the seed with its own salt,
+// so that rand, noise and the 3D rand stay uncorrelated like their sin
+// versions with different dot vectors.
+static uint32_t hashCoords(uint32_t salt, float a, float b) {
+    uint32_t h = hashMix(worldSeed ^ salt);
+    h = hashMix(h ^ coordBits(a));
+    return hashMix(h ^ coordBits(b));
+}
+
+static uint32_t hashCoords(uint32_t salt, float a, float b, float c) {
+    return hashMix(hashCoords(salt, a, b) ^ coordBits(c));
+}
+
+// top 24 bits as a float in [0, 1)
+static float unitFloat(uint32_t h) {
+    return (h >> 8) * (1.f / 16777216.f);
+}
+
+float Noise::rand(glm::vec2 co) {
+    if (currentBackend == Backend::INT_HASH) {
+        return unitFloat(hashCoords(0x68e31da4U, co.x, co.y));
+    }
+    return glm::fract(sin(glm::dot(co ,glm::vec2(12.9898,78.233))) * 43758.5453);
+}
 float Noise::rand(glm::vec2 co, float l) { return rand(glm::vec2(rand(co), l)); }
 float Noise::rand(glm::vec2 co, float l, float t) { return rand(glm::vec2(rand(co, l), t)); }
 
-float Noise::rand(glm::vec3 co) { return glm::fract(sin(glm::dot(co, glm::vec3(35.123125, 53.134536, 94.213515))) * 340913.2435); }
+float Noise::rand(glm::vec3 co) {
+    if (currentBackend == Backend::INT_HASH) {
+        return unitFloat(hashCoords(0xb5297a4dU, co.x, co.y, co.z));
+    }
+    return glm::fract(sin(glm::dot(co, glm::vec3(35.123125, 53.134536, 94.213515))) * 340913.2435);
+}
 
 float Noise::noise(glm::vec2 co){
+    if (currentBackend == Backend::INT_HASH) {
+        return unitFloat(hashCoords(0x1b56c4e9U, co.x, co.y));
+    }
     return glm::fract(sin(glm::dot(co ,glm::vec2(23.12456,69.233))) * 69210.4235);
 }
 
@@ -29,13 +91,18 @@ float Noise::interp2D(float x, float y) {
     return glm::mix(i1, i2, fractY);
 }
 
+float Noise::worley(glm::vec2 uv, float cells) {
+    return worley<1>(uv, cells);
+}
+
+template <int RADIUS>
 float Noise::worley(glm::vec2 uv, float cells) {
     uv *= cells;
     glm::vec2 uvInt = glm::vec2(floor(uv.x), floor(uv.y));
     glm::vec2 uvFract = glm::fract(uv);
-    float minDist = 3.0;
-    for(int y = -1; y <= 1; ++y) {
-        for(int x = -1; x <= 1; ++x) {
+    float minDist = RADIUS + 2.0;
+    for(int y = -RADIUS; y <= RADIUS; ++y) {
+        for(int x = -RADIUS; x <= RADIUS; ++x) {
             glm::vec2 neighbor = glm::vec2(float(x), float(y));
             glm::vec2 point = glm::vec2(noise(uvInt + neighbor));
             glm::vec2 diff = neighbor + point - uvFract;
@@ -73,10 +140,55 @@ float Noise::worley2(glm::vec2 uv) {
     return height;
 }
 
+// one octave of perlin, from the corner values c, cx, cy and cxy of the
+// cell p * dim lies in
+static float perlinCell(glm::vec2 p, float dim, float c, float cx, float cy, float cxy) {
+    glm::vec2 d = glm::fract(p * dim);
+    glm::vec2 dpi = glm::vec2(d.x * 3.1415, d.y * 3.1415);
+    d = glm::cos(dpi);
+    d *= -0.5;
+    d += 0.5;
+
+    float ccx = glm::mix(c, cx, d.x);
+    float cycxy = glm::mix(cy, cxy, d.x);
+    float center = glm::mix(ccx, cycxy, d.y);
+
+    return center * 2.0 - 1.0;
+}
+
+// frequency multiplier and amplitude of every perlin octave, doubling and
+// halving from 1, and the sum of the amplitudes
+template <int OCTAVES>
+struct PerlinOctaves {
+    std::array<float, OCTAVES> freq, amp;
+    float ampSum;
+
+    constexpr PerlinOctaves() : freq(), amp(), ampSum(0.f) {
+        float f = 1.f;
+        float a = 1.f;
+        for (int i = 0; i < OCTAVES; ++i) {
+            freq[i] = f;
+            amp[i] = a;
+            ampSum += a;
+            f *= 2.f;
+            a *= 0.5f;
+        }
+    }
+};
+
 // goes from -1 to 1
 // p must be normalized!
 float Noise::perlin(glm::vec2 p, float dim) {
-        glm::vec2 pos = glm::floor(p * dim);
+    return perlin<1>(p, dim);
+}
+
+template <int OCTAVES>
+float Noise::perlin(glm::vec2 p, float dim) {
+    static constexpr PerlinOctaves<OCTAVES> octaves;
+    float total = 0;
+    for (int i = 0; i < OCTAVES; ++i) {
+        float octaveDim = dim * octaves.freq[i];
+        glm::vec2 pos = glm::floor(p * octaveDim);
         glm::vec2 posx = pos + glm::vec2(1.0, 0.0);
         glm::vec2 posy = pos + glm::vec2(0.0, 1.0);
         glm::vec2 posxy = pos + glm::vec2(1.0);
@@ -87,22 +199,14 @@ float Noise::perlin(glm::vec2 p, float dim) {
         float cy = step(rand(posy, dim), 0.5);
         float cxy = step(rand(posxy, dim), 0.5);
 */
-        float c = rand(pos, dim);
-        float cx = rand(posx, dim);
-        float cy = rand(posy, dim);
-        float cxy = rand(posxy, dim);
-
-        glm::vec2 d = glm::fract(p * dim);
-        glm::vec2 dpi = glm::vec2(d.x * 3.1415, d.y * 3.1415);
-        d = glm::cos(dpi);
-        d *= -0.5;
-        d += 0.5;
-
-        float ccx = glm::mix(c, cx, d.x);
-        float cycxy = glm::mix(cy, cxy, d.x);
-        float center = glm::mix(ccx, cycxy, d.y);
+        float c = rand(pos, octaveDim);
+        float cx = rand(posx, octaveDim);
+        float cy = rand(posy, octaveDim);
+        float cxy = rand(posxy, octaveDim);
 
-        return center * 2.0 - 1.0;
+        total += perlinCell(p, octaveDim, c, cx, cy, cxy) * octaves.amp[i];
+    }
+    return total / octaves.ampSum;
 }
 
 // goes from -1 to 1
@@ -138,18 +242,190 @@ float Noise::perlin(glm::vec3 p, float dim) {
 
 }
 
+// remaps the summed octaves of fbm
+static float fbmShape(float total) {
+    return pow(glm::smoothstep(0.25, 0.75, pow(total, 1.3)), 1.03);
+}
+
+// frequency and amplitude of every fbm octave,
+// doubling and halving from 2 and 0.5
+template <int OCTAVES>
+struct FbmOctaves {
+    std::array<float, OCTAVES> freq, amp;
+
+    constexpr FbmOctaves() : freq(), amp() {
+        float persistence = 0.5f;
+        float f = 2.f;
+        float a = 0.5f;
+        for (int i = 0; i < OCTAVES; ++i) {
+            freq[i] = f;
+            amp[i] = a;
+            f *= 2.f;
+            a *= persistence;
+        }
+    }
+};
+
+float Noise::fbm(float x, float y) {
+    return fbm<8>(x, y);
+}
+
+template <int OCTAVES>
 float Noise::fbm(float x, float y) {
+    static constexpr FbmOctaves<OCTAVES> octaves;
     float total = 0;
-    float persistence = 0.5f;
-    int octaves = 8;
-    float freq = 2.f;
-    float amp = 0.5f;
-    for(int i = 1; i <= octaves; i++) {
-        total += interp2D(x * freq,
-                               y * freq) * amp;
-
-        freq *= 2.f;
-        amp *= persistence;
+    for(int i = 0; i < OCTAVES; i++) {
+        total += interp2D(x * octaves.freq[i],
+                          y * octaves.freq[i]) * octaves.amp[i];
     }
-    return pow(glm::smoothstep(0.25, 0.75, pow(total, 1.3)), 1.03);
+    return fbmShape(total);
+}
+
+void Noise::fbm(const float *x, const float *y, float *out, int n) {
+    fbm<8>(x, y, out, n);
+}
+
+template <int OCTAVES>
+void Noise::fbm(const float *x, const float *y, float *out, int n) {
+    static constexpr FbmOctaves<OCTAVES> octaves;
+    std::fill_n(out, n, 0.f);
+    for(int i = 0; i < OCTAVES; i++) {
+        float freq = octaves.freq[i];
+        float amp = octaves.amp[i];
+        // lattice corner values of the last cell we hashed
+        bool cached = false;
+        int cellX = 0, cellY = 0;
+        float v1 = 0, v2 = 0, v3 = 0, v4 = 0;
+
+        for (int s = 0; s < n; ++s) {
+            float px = x[s] * freq;
+            float py = y[s] * freq;
+            int intX = int(floor(px));
+            float fractX = glm::fract(px);
+            int intY = int(floor(py));
+            float fractY = glm::fract(py);
+
+            if (!cached || intX != cellX || intY != cellY) {
+                if (cached && intY == cellY && intX == cellX + 1) {
+                    // stepped one cell along x, so the old right corners are the new left ones
+                    v1 = v2;
+                    v3 = v4;
+                } else {
+                    v1 = noise(glm::vec2(intX, intY));
+                    v3 = noise(glm::vec2(intX, intY + 1));
+                }
+                v2 = noise(glm::vec2(intX + 1, intY));
+                v4 = noise(glm::vec2(intX + 1, intY + 1));
+                cached = true;
+                cellX = intX;
+                cellY = intY;
+            }
+
+            float i1 = glm::mix(v1, v2, fractX);
+            float i2 = glm::mix(v3, v4, fractX);
+            out[s] += glm::mix(i1, i2, fractY) * amp;
+        }
+    }
+    for (int s = 0; s < n; ++s) {
+        out[s] = fbmShape(out[s]);
+    }
+}
+
+void Noise::worley(const glm::vec2 *uvs, float cells, float *out, int n) {
+    worley<1>(uvs, cells, out, n);
+}
+
+template <int RADIUS>
+void Noise::worley(const glm::vec2 *uvs, float cells, float *out, int n) {
+    constexpr int SIDE = 2 * RADIUS + 1;
+    // hashed feature points of the cells around the last cell
+    bool cached = false;
+    glm::vec2 cachedInt;
+    std::array<float, SIDE * SIDE> points;
+
+    for (int s = 0; s < n; ++s) {
+        glm::vec2 uv = uvs[s] * cells;
+        glm::vec2 uvInt = glm::vec2(floor(uv.x), floor(uv.y));
+        glm::vec2 uvFract = glm::fract(uv);
+
+        if (!cached || uvInt != cachedInt) {
+            for(int y = -RADIUS; y <= RADIUS; ++y) {
+                for(int x = -RADIUS; x <= RADIUS; ++x) {
+                    points[(x + RADIUS) + SIDE * (y + RADIUS)] = noise(uvInt + glm::vec2(float(x), float(y)));
+                }
+            }
+            cached = true;
+            cachedInt = uvInt;
+        }
+
+        float minDist = RADIUS + 2.0;
+        for(int y = -RADIUS; y <= RADIUS; ++y) {
+            for(int x = -RADIUS; x <= RADIUS; ++x) {
+                glm::vec2 neighbor = glm::vec2(float(x), float(y));
+                glm::vec2 point = glm::vec2(points[(x + RADIUS) + SIDE * (y + RADIUS)]);
+                glm::vec2 diff = neighbor + point - uvFract;
+                float dist = glm::length(diff);
+                minDist = glm::min(minDist, dist);
+            }
+        }
+        out[s] = 1 - minDist - 0.02;
+    }
+}
+
+void Noise::perlin(const glm::vec2 *ps, float dim, float *out, int n) {
+    perlin<1>(ps, dim, out, n);
 }
+
+template <int OCTAVES>
+void Noise::perlin(const glm::vec2 *ps, float dim, float *out, int n) {
+    static constexpr PerlinOctaves<OCTAVES> octaves;
+    std::fill_n(out, n, 0.f);
+    for (int i = 0; i < OCTAVES; ++i) {
+        float octaveDim = dim * octaves.freq[i];
+        float amp = octaves.amp[i];
+        // corner values of the last cell we hashed
+        bool cached = false;
+        glm::vec2 cachedPos;
+        float c = 0, cx = 0, cy = 0, cxy = 0;
+
+        for (int s = 0; s < n; ++s) {
+            glm::vec2 p = ps[s];
+            glm::vec2 pos = glm::floor(p * octaveDim);
+
+            if (!cached || pos != cachedPos) {
+                glm::vec2 posx = pos + glm::vec2(1.0, 0.0);
+                glm::vec2 posy = pos + glm::vec2(0.0, 1.0);
+                glm::vec2 posxy = pos + glm::vec2(1.0);
+                c = rand(pos, octaveDim);
+                cx = rand(posx, octaveDim);
+                cy = rand(posy, octaveDim);
+                cxy = rand(posxy, octaveDim);
+                cached = true;
+                cachedPos = pos;
+            }
+
+            out[s] += perlinCell(p, octaveDim, c, cx, cy, cxy) * amp;
+        }
+    }
+    for (int s = 0; s < n; ++s) {
+        out[s] /= octaves.ampSum;
+    }
+}
+
+#define INSTANTIATE_OCTAVES(N) \
+    template float Noise::fbm<N>(float x, float y); \
+    template void Noise::fbm<N>(const float *x, const float *y, float *out, int n); \
+    template float Noise::perlin<N>(glm::vec2 p, float dim); \
+    template void Noise::perlin<N>(const glm::vec2 *p, float dim, float *out, int n);
+
+INSTANTIATE_OCTAVES(1)
+INSTANTIATE_OCTAVES(2)
+INSTANTIATE_OCTAVES(3)
+INSTANTIATE_OCTAVES(4)
+INSTANTIATE_OCTAVES(5)
+INSTANTIATE_OCTAVES(6)
+INSTANTIATE_OCTAVES(7)
+INSTANTIATE_OCTAVES(8)
+
+template float Noise::worley<1>(glm::vec2 uv, float cells);
+template void Noise::worley<1>(const glm::vec2 *uv, float cells, float *out, int n);
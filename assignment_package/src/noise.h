@@ -2,9 +2,27 @@
 
 #include "glm_includes.h"
 
+#include <cstdint>
+
+// Most octaves the templated fbm and perlin kernels are built for
+#define NOISE_MAX_OCTAVES 8
 
 namespace Noise
 {
+    // Which hash the pure noise functions below are built on.
+    // SIN_HASH is the original fract(sin(dot(...)) * k) hash, and generates
+    // the same worlds as always. It ignores the seed. INT_HASH hashes the bits
+    // of the coordinates with an integer mixer instead: it is cheaper, exact
+    // at any float coordinate, and different for every seed.
+    enum class Backend : unsigned char {
+        SIN_HASH, INT_HASH
+    };
+
+    // Not synchronized: call this before any terrain is generated
+    void setBackend(Backend backend, uint32_t seed = 0);
+    Backend getBackend();
+    uint32_t getSeed();
+
     // pure noise
 
     float rand(glm::vec2 co),
@@ -27,4 +45,41 @@ namespace Noise
 
     float fbm(float x, float y);
 
+    // batch versions, evaluating n samples at once into out.
+    // Samples should be close together, like a row of terrain columns:
+    // neighboring samples share their lattice hashes instead of recomputing
+    // them, and the per-sample arithmetic is laid out in flat loops the
+    // compiler can vectorize. Results are bit-identical to the scalar
+    // versions (tolerance 0), since they run the same float operations.
+
+    void fbm(const float *x, const float *y, float *out, int n);
+
+    void worley(const glm::vec2 *uv, float cells, float *out, int n);
+
+    void perlin(const glm::vec2 *p, float dim, float *out, int n);
+
+    // Compile-time specialised kernels. OCTAVES is the number of fbm or
+    // perlin octaves, whose frequencies and amplitudes are precomputed, and
+    // RADIUS is how many cells around the sample's own cell worley searches
+    // for the closest feature point. perlin's octaves start at dim and
+    // double in frequency, halving in amplitude, and their sum is scaled
+    // back to [-1, 1]. The plain versions are fbm<8>, perlin<1> and
+    // worley<1>. noise.cpp builds fbm and perlin for 1 to NOISE_MAX_OCTAVES
+    // octaves, and worley<1> only.
+
+    template <int OCTAVES>
+    float fbm(float x, float y);
+    template <int OCTAVES>
+    void fbm(const float *x, const float *y, float *out, int n);
+
+    template <int OCTAVES>
+    float perlin(glm::vec2 p, float dim);
+    template <int OCTAVES>
+    void perlin(const glm::vec2 *p, float dim, float *out, int n);
+
+    template <int RADIUS>
+    float worley(glm::vec2 uv, float cells);
+    template <int RADIUS>
+    void worley(const glm::vec2 *uv, float cells, float *out, int n);
+
 };
@@ -0,0 +1,80 @@
+#include "noiselayer.h"
+
+#include "noise.h"
+
+#include <type_traits>
+#include <vector>
+
+
+const std::array<NoiseLayer, TerrainNoise::LAYER_COUNT> TerrainNoise::layers = {{
+    //  kernel              param   octaves  shift  scale    offsetX    offsetZ   wide
+    { NoiseLayer::FBM,      0.f,    8,       0,     0.004f,  63.841f,   83.4517f, false }, // HEIGHT_BLEND
+    { NoiseLayer::FBM,      0.f,    8,       0,     0.004f,  0.f,       0.f,      false }, // HUMIDITY_BLEND
+    { NoiseLayer::FBM,      0.f,    8,       0,     0.001f,  0.f,       0.f,      false }, // OCEAN_WEIGHT
+    { NoiseLayer::WORLEY,   0.01f,  1,       0,     1.f,     0.f,       0.f,      false }, // GRASS_CELLS
+    { NoiseLayer::FBM,      0.f,    8,       0,     0.05,    0.f,       0.f,      true  }, // GRASS_DETAIL
+    { NoiseLayer::FBM,      0.f,    8,       0,     0.005,   0.f,       0.f,      true  }, // MOUNTAIN_1
+    { NoiseLayer::FBM,      0.f,    8,       9000,  0.005,   0.f,       0.f,      true  }, // MOUNTAIN_2
+    { NoiseLayer::PERLIN,   0.02f,  1,       0,     1.f,     0.f,       0.f,      false }, // ARCHIPELAGO_BIG
+    { NoiseLayer::PERLIN,   0.1f,   1,       0,     1.f,     0.f,       0.f,      false }, // ARCHIPELAGO_SMALL
+    { NoiseLayer::FBM,      0.f,    8,       0,     0.003f,  1593.2f,   234.3f,   false }, // DESERT_DUNES
+}};
+
+glm::vec2 NoiseLayer::coords(int x, int z) const {
+    if (wide) {
+        return glm::vec2((x + shift) * scale + offsetX, (z + shift) * scale + offsetZ);
+    }
+    float s = scale;
+    return glm::vec2((x + shift) * s + offsetX, (z + shift) * s + offsetZ);
+}
+
+// Calls f with std::integral_constant<int, octaves>, so that it can pick
+// the kernel built for that many octaves. octaves is clamped to
+// 1..NOISE_MAX_OCTAVES.
+template <int N = 1, typename F>
+static auto withOctaves(int octaves, F &&f) {
+    if constexpr (N < NOISE_MAX_OCTAVES) {
+        if (octaves > N) {
+            return withOctaves<N + 1>(octaves, f);
+        }
+    }
+    return f(std::integral_constant<int, N>());
+}
+
+float NoiseLayer::sample(int x, int z) const {
+    glm::vec2 p = coords(x, z);
+    switch (kernel) {
+    case FBM:
+        return withOctaves(octaves, [&](auto o) { return Noise::fbm<decltype(o)::value>(p.x, p.y); });
+    case PERLIN:
+        return withOctaves(octaves, [&](auto o) { return Noise::perlin<decltype(o)::value>(p, param); });
+    case WORLEY:
+        return Noise::worley<1>(p, param);
+    }
+    return 0.f;
+}
+
+void NoiseLayer::sampleRow(int x, int z, int n, float *out) const {
+    std::vector<glm::vec2> ps(n);
+    for (int i = 0; i < n; ++i) {
+        ps[i] = coords(x + i, z);
+    }
+
+    switch (kernel) {
+    case FBM: {
+        std::vector<float> xs(n), zs(n);
+        for (int i = 0; i < n; ++i) {
+            xs[i] = ps[i].x;
+            zs[i] = ps[i].y;
+        }
+        withOctaves(octaves, [&](auto o) { Noise::fbm<decltype(o)::value>(xs.data(), zs.data(), out, n); });
+        break;
+    }
+    case PERLIN:
+        withOctaves(octaves, [&](auto o) { Noise::perlin<decltype(o)::value>(ps.data(), param, out, n); });
+        break;
+    case WORLEY:
+        Noise::worley<1>(ps.data(), param, out, n);
+        break;
+    }
+}
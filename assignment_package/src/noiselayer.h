@@ -0,0 +1,54 @@
+#pragma once
+
+#include "glm_includes.h"
+
+#include <array>
+
+
+// One noise field of the terrain generator, described as data: which kernel
+// it samples, and how world columns map to the kernel's coordinates.
+struct NoiseLayer
+{
+    enum Kernel : unsigned char {
+        FBM, PERLIN, WORLEY
+    };
+
+    Kernel kernel;
+    // worley cells or perlin dim; unused by fbm
+    float param;
+    // fbm or perlin octaves, from 1 to NOISE_MAX_OCTAVES; unused by worley
+    int octaves;
+
+    // column (x, z) maps to ((x + shift) * scale + offsetX, (z + shift) * scale + offsetZ).
+    // With wide set the scale is applied in double precision before rounding
+    // to float, otherwise scale is a float constant and everything is float.
+    int shift;
+    double scale;
+    float offsetX, offsetZ;
+    bool wide;
+
+    glm::vec2 coords(int x, int z) const;
+
+    float sample(int x, int z) const;
+    // samples the n columns starting at (x, z) and running along +x
+    void sampleRow(int x, int z, int n, float *out) const;
+};
+
+// The layers of the climate and terrain height functions in Chunk
+namespace TerrainNoise
+{
+    enum Layer {
+        HEIGHT_BLEND, HUMIDITY_BLEND, OCEAN_WEIGHT,
+        GRASS_CELLS, GRASS_DETAIL,
+        MOUNTAIN_1, MOUNTAIN_2,
+        ARCHIPELAGO_BIG, ARCHIPELAGO_SMALL,
+        DESERT_DUNES,
+        LAYER_COUNT
+    };
+
+    extern const std::array<NoiseLayer, LAYER_COUNT> layers;
+
+    inline const NoiseLayer& layer(Layer l) {
+        return layers[l];
+    }
+};
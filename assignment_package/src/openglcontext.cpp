@@ -8,7 +8,7 @@
 
 
 OpenGLContext::OpenGLContext(QWidget *parent)
-    : QOpenGLWidget(parent)
+    : QOpenGLWidget(parent), mp_multiDrawElementsBaseVertex(nullptr)
 {}
 
 OpenGLContext::~OpenGLContext()
@@ -69,6 +69,28 @@ void OpenGLContext::debugContextVersion()
     }
 }
 
+void OpenGLContext::initializeMultiDraw()
+{
+    mp_multiDrawElementsBaseVertex = reinterpret_cast<MultiDrawElementsBaseVertexFn>(
+                context()->getProcAddress("glMultiDrawElementsBaseVertex"));
+    if (mp_multiDrawElementsBaseVertex == nullptr) {
+        printf("WARNING: glMultiDrawElementsBaseVertex is unavailable, drawing chunks one call at a time\n");
+    }
+}
+
+void OpenGLContext::glMultiDrawElementsBaseVertex(GLenum mode, const GLsizei *count, GLenum type,
+                                                  const void *const *indices, GLsizei drawcount,
+                                                  const GLint *basevertex)
+{
+    if (mp_multiDrawElementsBaseVertex != nullptr) {
+        mp_multiDrawElementsBaseVertex(mode, count, type, indices, drawcount, basevertex);
+        return;
+    }
+    for (GLsizei i = 0; i < drawcount; ++i) {
+        glDrawElementsBaseVertex(mode, count[i], type, indices[i], basevertex[i]);
+    }
+}
+
 void OpenGLContext::printGLErrorLog()
 {
     GLenum error = glGetError();
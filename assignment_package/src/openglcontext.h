@@ -18,4 +18,19 @@ public:
     void printGLErrorLog();
     void printLinkInfoLog(int prog);
     void printShaderInfoLog(int shader);
+
+    // Looks up the desktop GL functions QOpenGLExtraFunctions doesn't
+    // cover. Call after initializeOpenGLFunctions.
+    void initializeMultiDraw();
+    // Draws drawcount index ranges of the bound element buffer in one call.
+    // Falls back to one glDrawElementsBaseVertex per range on drivers
+    // without it.
+    void glMultiDrawElementsBaseVertex(GLenum mode, const GLsizei *count, GLenum type,
+                                       const void *const *indices, GLsizei drawcount,
+                                       const GLint *basevertex);
+
+private:
+    typedef void (QOPENGLF_APIENTRYP MultiDrawElementsBaseVertexFn)(GLenum, const GLsizei*, GLenum,
+                                                                  const void *const*, GLsizei, const GLint*);
+    MultiDrawElementsBaseVertexFn mp_multiDrawElementsBaseVertex;
 };
@@ -36,3 +36,18 @@ void PlayerInfo::slot_setZoneText(QString s) {
     ui->zoneLabel->setText(s);
 }
 
+void PlayerInfo::slot_setDrawStatsText(QString s) {
+    ui->drawStatsLabel->setText(s);
+}
+
+void PlayerInfo::slot_setArenaStatsText(QString s) {
+    ui->arenaStatsLabel->setText(s);
+}
+
+void PlayerInfo::slot_setRenderDistanceText(QString s) {
+    ui->renderDistanceLabel->setText(s);
+}
+
+void PlayerInfo::slot_setWeatherStatsText(QString s) {
+    ui->weatherStatsLabel->setText(s);
+}
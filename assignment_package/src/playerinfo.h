@@ -20,6 +20,10 @@ public slots:
     void slot_setLookText(QString);
     void slot_setChunkText(QString);
     void slot_setZoneText(QString);
+    void slot_setDrawStatsText(QString);
+    void slot_setArenaStatsText(QString);
+    void slot_setRenderDistanceText(QString);
+    void slot_setWeatherStatsText(QString);
 
 private:
     Ui::PlayerInfo *ui;
@@ -0,0 +1,72 @@
+#include "renderdistance.h"
+#include <algorithm>
+
+RenderDistance::RenderDistance(const RenderDistanceConfig &config)
+    : m_config(config),
+      m_radius(std::clamp(config.startRadius, config.minRadius, config.maxRadius)),
+      m_frameMs(), m_uploadMs(), m_next(0), m_samples(0), m_sorted()
+{
+    m_frameMs.reserve(config.window);
+    m_uploadMs.reserve(config.window);
+}
+
+bool RenderDistance::addFrame(float frameMs, float uploadMs) {
+    float workMs = std::max(frameMs - uploadMs, 0.f);
+    if (static_cast<int>(m_frameMs.size()) < m_config.window) {
+        m_frameMs.push_back(workMs);
+        m_uploadMs.push_back(uploadMs);
+    } else {
+        m_frameMs[m_next] = workMs;
+        m_uploadMs[m_next] = uploadMs;
+    }
+    m_next = (m_next + 1) % m_config.window;
+
+    // Decide once per full window, so every decision is measured entirely
+    // at the radius the last one picked
+    if (++m_samples < m_config.window) {
+        return false;
+    }
+    m_samples = 0;
+
+    float frame95 = framePercentile(0.95f);
+    int radius = m_radius;
+    if (frame95 > m_config.frameBudgetMs) {
+        radius = std::max(m_radius - 1, m_config.minRadius);
+    } else if (frame95 < m_config.frameBudgetMs * m_config.growBelow
+               && uploadPercentile(0.95f) < m_config.uploadBudgetMs) {
+        radius = std::min(m_radius + 1, m_config.maxRadius);
+    }
+    if (radius == m_radius) {
+        return false;
+    }
+    m_radius = radius;
+    return true;
+}
+
+float RenderDistance::percentile(const std::vector<float> &times, float p) const {
+    if (times.empty()) {
+        return 0.f;
+    }
+    m_sorted = times;
+    size_t n = std::min(static_cast<size_t>(p * m_sorted.size()), m_sorted.size() - 1);
+    std::nth_element(m_sorted.begin(), m_sorted.begin() + n, m_sorted.end());
+    return m_sorted[n];
+}
+
+int RenderDistance::radius() const {
+    return m_radius;
+}
+
+int RenderDistance::zoneRadius() const {
+    // The player may stand anywhere in their zone, so it takes this many
+    // zones on each side to reach radius chunks past its edge
+    return (m_radius + 3) / 4;
+}
+
+float RenderDistance::framePercentile(float p) const {
+    return percentile(m_frameMs, p);
+}
+
+float RenderDistance::uploadPercentile(float p) const {
+    return percentile(m_uploadMs, p);
+}
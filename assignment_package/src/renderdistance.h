@@ -0,0 +1,66 @@
+#pragma once
+#include <vector>
+
+// Bounds and targets for a RenderDistance controller
+struct RenderDistanceConfig {
+    // Draw radius, in chunks, the controller stays within and starts at
+    int minRadius = 4;
+    int maxRadius = 12;
+    int startRadius = 8;
+    // The radius shrinks when the 95th percentile frame time goes over
+    // this, in milliseconds: just under a 60 Hz frame
+    float frameBudgetMs = 16.f;
+    // It only grows when the 95th percentile frame time is under this
+    // fraction of the budget, so a radius that just fits doesn't flip
+    // back and forth...
+    float growBelow = 0.6f;
+    // ...and when uploads have settled: the 95th percentile time spent
+    // uploading meshes each frame is under this, in milliseconds
+    float uploadBudgetMs = 1.f;
+    // Frames measured before each decision. A decision starts a new window.
+    int window = 120;
+};
+
+// Picks how far out to draw and generate terrain from how long frames take.
+// MyGL feeds it the time of every frame, the longer of its CPU time and the
+// time the GPU spent on its commands, along with the part of it spent
+// uploading chunk meshes, and it steps the radius a chunk at a time between
+// the configured bounds. Upload time is left out of the frame time it
+// compares against the budget, since uploads come in bursts whenever the
+// radius grows or the player crosses into a new zone, and shrinking for
+// them would undo the growth that caused them.
+class RenderDistance {
+private:
+    RenderDistanceConfig m_config;
+    int m_radius;
+    // The last window's frame and upload times, in milliseconds, as
+    // ring buffers
+    std::vector<float> m_frameMs;
+    std::vector<float> m_uploadMs;
+    int m_next;
+    // Frames recorded since the last decision
+    int m_samples;
+    // Scratch space for finding percentiles
+    mutable std::vector<float> m_sorted;
+
+    // The pth percentile (0 to 1) of the recorded values of times
+    float percentile(const std::vector<float> &times, float p) const;
+
+public:
+    RenderDistance(const RenderDistanceConfig &config = RenderDistanceConfig());
+
+    // Records one frame's time and the part of it spent uploading
+    // meshes. Returns true if the radius changed.
+    bool addFrame(float frameMs, float uploadMs);
+
+    // Draw radius, in chunks
+    int radius() const;
+    // Radius, in 64 x 64 zones around the player's, to generate so that
+    // everything within radius() of the player is loaded
+    int zoneRadius() const;
+    // Percentiles (0 to 1) of the last window's frame times, not counting
+    // uploads, in milliseconds. 0 before any frame is recorded.
+    float framePercentile(float p) const;
+    // Percentiles of the last window's upload times, in milliseconds
+    float uploadPercentile(float p) const;
+};
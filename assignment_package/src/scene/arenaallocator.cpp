@@ -0,0 +1,96 @@
+#include "arenaallocator.h"
+#include <algorithm>
+#include <iterator>
+
+ArenaAllocator::ArenaAllocator(unsigned int capacity)
+    : m_freeBlocks{{0, capacity}}, m_capacity(capacity), m_used(0), m_allocations(0)
+{}
+
+bool ArenaAllocator::allocate(unsigned int size, ArenaRange &range) {
+    auto best = m_freeBlocks.end();
+    for (auto it = m_freeBlocks.begin(); it != m_freeBlocks.end(); ++it) {
+        if (it->second >= size && (best == m_freeBlocks.end() || it->second < best->second)) {
+            best = it;
+            if (best->second == size) break;
+        }
+    }
+    if (best == m_freeBlocks.end()) {
+        return false;
+    }
+    range.offset = best->first;
+    range.size = size;
+    // keep what's left of the block at its end
+    unsigned int rest = best->second - size;
+    m_freeBlocks.erase(best);
+    if (rest > 0) {
+        m_freeBlocks[range.offset + size] = rest;
+    }
+    m_used += size;
+    ++m_allocations;
+    return true;
+}
+
+void ArenaAllocator::free(ArenaRange &range) {
+    if (range.size == 0) {
+        return;
+    }
+    unsigned int offset = range.offset, size = range.size;
+    auto next = m_freeBlocks.lower_bound(offset);
+    // merge with the free block right after...
+    if (next != m_freeBlocks.end() && next->first == offset + size) {
+        size += next->second;
+        next = m_freeBlocks.erase(next);
+    }
+    // ...and the one right before
+    if (next != m_freeBlocks.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            prev->second += size;
+            size = 0;
+        }
+    }
+    if (size > 0) {
+        m_freeBlocks[offset] = size;
+    }
+    m_used -= range.size;
+    --m_allocations;
+    range = ArenaRange();
+}
+
+void ArenaAllocator::grow(unsigned int capacity) {
+    unsigned int offset = m_capacity, size = capacity - m_capacity;
+    m_capacity = capacity;
+    // extend the free block ending at the old end, if there is one
+    if (!m_freeBlocks.empty()) {
+        auto last = std::prev(m_freeBlocks.end());
+        if (last->first + last->second == offset) {
+            last->second += size;
+            return;
+        }
+    }
+    m_freeBlocks[offset] = size;
+}
+
+unsigned int ArenaAllocator::capacity() const {
+    return m_capacity;
+}
+
+unsigned int ArenaAllocator::used() const {
+    return m_used;
+}
+
+int ArenaAllocator::allocations() const {
+    return m_allocations;
+}
+
+int ArenaAllocator::freeBlocks() const {
+    return static_cast<int>(m_freeBlocks.size());
+}
+
+unsigned int ArenaAllocator::largestFreeBlock() const {
+    unsigned int largest = 0;
+    for (auto &block : m_freeBlocks) {
+        largest = std::max(largest, block.second);
+    }
+    return largest;
+}
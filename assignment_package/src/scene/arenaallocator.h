@@ -0,0 +1,44 @@
+#pragma once
+#include <map>
+
+// A run of elements handed out by an ArenaAllocator
+struct ArenaRange {
+    unsigned int offset = 0;
+    unsigned int size = 0;
+};
+
+// Hands out ranges of a buffer of some capacity from a free list. Free
+// blocks are kept sorted by offset so a freed range merges with the free
+// blocks on either side of it, and each allocation takes the smallest
+// free block that fits, which keeps the large ones whole.
+class ArenaAllocator {
+private:
+    // Offset -> size of every free block
+    std::map<unsigned int, unsigned int> m_freeBlocks;
+    unsigned int m_capacity;
+    unsigned int m_used;
+    int m_allocations;
+
+public:
+    ArenaAllocator(unsigned int capacity);
+
+    // Finds room for size (> 0) elements. Returns false, leaving range
+    // untouched, if no free block is large enough.
+    bool allocate(unsigned int size, ArenaRange &range);
+    // Returns range to the free list and empties it
+    void free(ArenaRange &range);
+    // Appends free space up to the new, larger, capacity
+    void grow(unsigned int capacity);
+
+    unsigned int capacity() const;
+    unsigned int used() const;
+    int allocations() const;
+    int freeBlocks() const;
+    unsigned int largestFreeBlock() const;
+};
+
+// Where one chunk mesh lives in a ChunkArena
+struct ArenaMesh {
+    ArenaRange vertices;
+    ArenaRange indices;
+};
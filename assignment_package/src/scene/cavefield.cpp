@@ -0,0 +1,141 @@
+#include "cavefield.h"
+
+#include "noise.h"
+
+static CaveField::Quality currentQuality = CaveField::EXACT;
+
+const float CaveField::REFINE_MARGIN = 0.02f;
+const float CaveField::MERGE_RADIUS = 0.045f;
+const int CaveField::LATTICE_XZ = 16 / STEP_XZ + 1;
+const int CaveField::LATTICE_Y = CAVE_HEIGHT / STEP_Y + 1;
+
+void CaveField::setQuality(Quality quality) {
+    currentQuality = quality;
+}
+
+CaveField::Quality CaveField::getQuality() {
+    return currentQuality;
+}
+
+CaveField::CaveField(int x, int z, Quality quality)
+    : X(x), Z(z), quality(quality), m_spaghetti(), m_cheese()
+{
+    if (quality == EXACT) {
+        return;
+    }
+
+    // the lattice also covers the far edges, so every block has 8 corners
+    m_spaghetti.resize(LATTICE_XZ * LATTICE_Y * LATTICE_XZ);
+    m_cheese.resize(LATTICE_XZ * LATTICE_Y * LATTICE_XZ);
+    for (int k = 0; k < LATTICE_XZ; ++k) {
+        for (int j = 0; j < LATTICE_Y; ++j) {
+            for (int i = 0; i < LATTICE_XZ; ++i) {
+                int idx = i + LATTICE_XZ * j + LATTICE_XZ * LATTICE_Y * k;
+                m_spaghetti[idx] = spaghettiNoise(X + i * STEP_XZ, j * STEP_Y, Z + k * STEP_XZ);
+                m_cheese[idx] = cheeseNoise(X + i * STEP_XZ, j * STEP_Y, Z + k * STEP_XZ);
+            }
+        }
+    }
+}
+
+std::pair<int, int> CaveField::carveBounds(int columnTop) {
+    static const std::pair<int, int> envelope = heightClipEnvelope();
+    // above the column's top block carving only replaces air with air,
+    // except under y = 24 where it would still fill the air with lava
+    int top = glm::max(columnTop + 1, 24);
+    return std::make_pair(envelope.first, glm::min(envelope.second, top));
+}
+
+std::pair<int, int> CaveField::heightClipEnvelope() {
+    // caveCarve never goes below -MERGE_RADIUS, so a block is only carved where
+    // -heightClip is above that. This holds for the float results too,
+    // since the subtraction in caveCarve rounds monotonically.
+    int first = CAVE_HEIGHT, last = 0;
+    for (int y = 0; y < CAVE_HEIGHT; ++y) {
+        if (-heightClip(y) > -MERGE_RADIUS) {
+            first = glm::min(first, y);
+            last = glm::max(last, y + 1);
+        }
+    }
+    return std::make_pair(first, glm::max(first, last));
+}
+
+float CaveField::heightClip(int y) {
+    // blend to top
+    float mappedHeight = (y + 3.f) / (128.f - 3.f);
+    return (glm::smoothstep(0.75f, 1.0f, mappedHeight) + glm::smoothstep(0.75f, 1.f, 1.f - y));
+}
+
+bool CaveField::carves(int cx, int y, int cz, float spaghettiMask, float cheeseMask) const {
+    float clip = heightClip(y);
+
+    int x = X + cx, z = Z + cz;
+    if (quality == EXACT) {
+        float spaghetti = spaghettiSdf(spaghettiNoise(x, y, z), spaghettiMask);
+        // The merged length is at least |spaghetti|, so far enough inside a
+        // spaghetti cave the cheese noise can't change the outcome. The slack
+        // covers the rounding of the length.
+        if (spaghetti < -(MERGE_RADIUS - clip) - 1e-4f) {
+            return false;
+        }
+        glm::vec2 sdf(spaghetti, cheeseSdf(cheeseNoise(x, y, z), cheeseMask));
+        return caveCarve(sdf) < -clip;
+    }
+
+    glm::vec2 sdf(spaghettiSdf(interpolate(m_spaghetti, cx, y, cz), spaghettiMask),
+                  cheeseSdf(interpolate(m_cheese, cx, y, cz), cheeseMask));
+    float carve = caveCarve(sdf);
+    // With both distances clearly positive the carve value is flat at -MERGE_RADIUS,
+    // so only blocks near a cave wall and near the threshold can flip
+    if (quality == REFINED && glm::min(sdf.x, sdf.y) < REFINE_MARGIN
+            && glm::abs(carve + clip) < REFINE_MARGIN) {
+        sdf = glm::vec2(spaghettiSdf(spaghettiNoise(x, y, z), spaghettiMask),
+                        cheeseSdf(cheeseNoise(x, y, z), cheeseMask));
+        carve = caveCarve(sdf);
+    }
+    return carve < -clip;
+}
+
+float CaveField::spaghettiNoise(int x, int y, int z) {
+    return Noise::perlin(glm::vec3(x, y, z), 0.03f);
+}
+
+float CaveField::cheeseNoise(int x, int y, int z) {
+    return Noise::perlin(glm::vec3(x, y, z) + glm::vec3(2309.363), 0.019f) * 0.5f + 0.5f;
+}
+
+float CaveField::spaghettiSdf(float spaghettiCaveCarve, float spaghettiMask) {
+    // edges of noise and such (like spaghetti)
+    float spaghettiFill = glm::mix(0.085f, 0.13f, spaghettiMask);
+    return glm::mix(-spaghettiFill, 1.f - spaghettiFill, glm::abs(spaghettiCaveCarve));
+}
+
+float CaveField::cheeseSdf(float cheeseCarve, float cheeseMask) {
+    // holes like swiss cheese
+    float cheeseFill = glm::mix(0.075f, 0.12f, cheeseMask);
+    return glm::mix(-cheeseFill, 1.f - cheeseFill, cheeseCarve);
+}
+
+float CaveField::caveCarve(glm::vec2 sdf) {
+    glm::vec2 mergeVec = glm::min(sdf, glm::vec2(0));
+    return glm::length(mergeVec) - MERGE_RADIUS;
+}
+
+float CaveField::interpolate(const std::vector<float> &lattice, int cx, int y, int cz) const {
+    int i = cx / STEP_XZ, j = y / STEP_Y, k = cz / STEP_XZ;
+    float tx = (cx % STEP_XZ) / float(STEP_XZ);
+    float ty = (y % STEP_Y) / float(STEP_Y);
+    float tz = (cz % STEP_XZ) / float(STEP_XZ);
+
+    int idx = i + LATTICE_XZ * j + LATTICE_XZ * LATTICE_Y * k;
+    int dy = LATTICE_XZ, dz = LATTICE_XZ * LATTICE_Y;
+
+    float x00 = glm::mix(lattice[idx], lattice[idx + 1], tx);
+    float x10 = glm::mix(lattice[idx + dy], lattice[idx + dy + 1], tx);
+    float x01 = glm::mix(lattice[idx + dz], lattice[idx + dz + 1], tx);
+    float x11 = glm::mix(lattice[idx + dy + dz], lattice[idx + dy + dz + 1], tx);
+
+    float back = glm::mix(x00, x10, ty);
+    float front = glm::mix(x01, x11, ty);
+    return glm::mix(back, front, tz);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "glm_includes.h"
+
+#include <utility>
+#include <vector>
+
+// The cave noise of one chunk, for the cave carving pass of terrain generation.
+// Computing both 3D perlin noises exactly for every block below the cave
+// ceiling dominates generation time, so the field can instead be sampled on
+// a coarse lattice and trilinearly interpolated per block.
+class CaveField
+{
+public:
+    enum Quality : unsigned char {
+        // both noises evaluated for every block: the original caves
+        EXACT,
+        // interpolated, but any block whose carve value lands within
+        // REFINE_MARGIN of the carve threshold is recomputed exactly
+        REFINED,
+        // interpolated only
+        FAST
+    };
+
+    // Not synchronized: call this before any terrain is generated
+    static void setQuality(Quality quality);
+    static Quality getQuality();
+
+    // caves are only carved below this height
+    static const int CAVE_HEIGHT = 128;
+    // lattice spacing of the interpolated qualities, in blocks
+    static const int STEP_XZ = 4, STEP_Y = 8;
+    // distance from the carve threshold under which REFINED recomputes exactly.
+    // An interpolation error smaller than this can never flip a block.
+    static const float REFINE_MARGIN;
+
+    // The field of the chunk whose lower-left corner is (x, z)
+    CaveField(int x, int z, Quality quality = getQuality());
+
+    const int X, Z;
+    const Quality quality;
+
+    // The heights [first, second) where the cave pass can change a block of
+    // a column whose highest non-empty block is at columnTop. Everywhere
+    // else heightClip rules carving out, or it would only replace air with air.
+    static std::pair<int, int> carveBounds(int columnTop);
+
+    // Does the cave pass carve out this block? cx and cz are chunk-local,
+    // and the masks are the per-column cave masks of generateTerrainColumn.
+    bool carves(int cx, int y, int cz, float spaghettiMask, float cheeseMask) const;
+
+private:
+    static const int LATTICE_XZ, LATTICE_Y;
+
+    static float spaghettiNoise(int x, int y, int z);
+    static float cheeseNoise(int x, int y, int z);
+    static const float MERGE_RADIUS;
+
+    static float heightClip(int y);
+    // The heights where heightClip still allows carving
+    static std::pair<int, int> heightClipEnvelope();
+
+    // Distances to the spaghetti and cheese cave walls, negative inside a cave
+    static float spaghettiSdf(float spaghettiCaveCarve, float spaghettiMask);
+    static float cheeseSdf(float cheeseCarve, float cheeseMask);
+    // Merges both distances into the carve value, carved when below -heightClip
+    static float caveCarve(glm::vec2 sdf);
+
+    float interpolate(const std::vector<float> &lattice, int cx, int y, int cz) const;
+
+    // lattice samples, x fastest then y then z
+    std::vector<float> m_spaghetti, m_cheese;
+};
@@ -1,11 +1,14 @@
 #include "chunk.h"
 
 #include "noise.h"
+#include "noiselayer.h"
+#include "climatemap.h"
+#include "cavefield.h"
 
-#include "structuredata/pyramid.h"
-#include "structuredata/tree.h"
-#include "structuredata/icespike.h"
-#include "structuredata/lookout.h"
+#include "structureregistry.h"
+#include "structuredata/stencil.h"
+
+#include <algorithm>
 
 
 VertexData::VertexData(glm::vec4 p, glm::vec2 u) : pos(p), uv(u) {}
@@ -20,49 +23,78 @@ size_t EnumHash::operator()(T t) const {
     return static_cast<size_t>(t);
 }
 
-Chunk::Chunk(OpenGLContext* context, int x, int z) : Drawable(context), X(x), Z(z), m_blocks(),
-    m_neighbors{{XPOS, nullptr}, {XNEG, nullptr}, {ZPOS, nullptr}, {ZNEG, nullptr}}, isBuffered(false)
+Chunk::Chunk(int x, int z, ChunkArena* arena) : X(x), Z(z), m_blocks(),
+    m_neighbors{{XPOS, nullptr}, {XNEG, nullptr}, {ZPOS, nullptr}, {ZNEG, nullptr}}, isBuffered(false), isGenerated(false),
+    mp_arena(arena), m_meshOpq(), m_meshTra(), m_countOpq(-1), m_countTra(-1),
+    m_sectionConnectivity(), m_meshMinY(HEIGHT), m_meshMaxY(0),
+    m_drawEntry(-1)
 {}
 
 Chunk::~Chunk()
 {}
 
-void Chunk::generateTerrain() {
+void Chunk::generateTerrain(const ClimateMap *climate, StructureRegistry *structures) {
+    // without a zone map covering us, compute one for just this chunk
+    uPtr<ClimateMap> chunkClimate;
+    if (climate == nullptr || !climate->contains(X, Z) || !climate->contains(X + WIDTH - 1, Z + WIDTH - 1)) {
+        chunkClimate = mkU<ClimateMap>(X, Z, WIDTH);
+        climate = chunkClimate.get();
+    }
+
+    uPtr<StructureRegistry> chunkStructures;
+    if (structures == nullptr) {
+        chunkStructures = mkU<StructureRegistry>();
+        structures = chunkStructures.get();
+    }
+
+    generateColumns(*climate);
+    generateStructures(*climate, *structures);
+}
+
+void Chunk::generateColumns(const ClimateMap &climate) {
     // fill with empty first
     std::fill_n(m_blocks.begin(), HEIGHT * WIDTH * WIDTH, EMPTY);
 
+    CaveField caves(X, Z);
+
     // iterate through all XZ in chunk
     for (int cx = 0; cx < Chunk::WIDTH; ++cx) {
         for (int cz = 0; cz < Chunk::WIDTH; ++cz) {
-            generateTerrainColumn(cx, cz);
+            generateTerrainColumn(cx, cz, climate.at(X + cx, Z + cz), caves);
         }
     }
+}
 
-    // generate structures
-    std::vector<uPtr<Structure>> structures = getStructures();
-
-    glm::ivec3 chunkBoundsMin{X, 0, Z};
-    glm::ivec3 chunkBoundsMax{X + WIDTH, HEIGHT, Z + WIDTH};
+void Chunk::generateStructures(const ClimateMap &climate, StructureRegistry &structures) {
+    for (const sPtr<const PlacedStructure> &placed : structures.query(X, Z, X + WIDTH, Z + WIDTH, climate)) {
+        stampStencil(*placed->stencil, placed->root);
+    }
+}
 
-    for (auto& structure : structures) {
-        int x = structure->pos.x, z = structure->pos.y;
-        int rootHeight = getTerrainHeight(x, z);
+void Chunk::stampStencil(const StructureStencil &stencil, glm::ivec3 root)
+{
+    // the stencil's box in world space, clipped to this chunk
+    glm::ivec3 lo = glm::max(root + stencil.min, glm::ivec3(X, 0, Z));
+    glm::ivec3 hi = glm::min(root + stencil.max, glm::ivec3(X + WIDTH, HEIGHT, Z + WIDTH));
+    int length = hi.x - lo.x;
+    if (length <= 0 || lo.y >= hi.y || lo.z >= hi.z) {
+        return;
+    }
 
-        glm::ivec3 rootPos = glm::ivec3(x, rootHeight, z);
-        auto blocks = structure->getStructureBlocks();
-        for (auto& block : blocks) {
-            glm::ivec3 pos = block.second + rootPos;
-            if (pos.x < chunkBoundsMin.x || pos.y < chunkBoundsMin.y || pos.z < chunkBoundsMin.z
-                    || pos.x >= chunkBoundsMax.x || pos.y >= chunkBoundsMax.y || pos.z >= chunkBoundsMax.z) {
-                continue;
+    for (int z = lo.z; z < hi.z; ++z) {
+        for (int y = lo.y; y < hi.y; ++y) {
+            const BlockType *src = stencil.row(y - root.y, z - root.z) + (lo.x - root.x - stencil.min.x);
+            BlockType *dst = &m_blocks[(lo.x - X) + WIDTH * y + WIDTH * HEIGHT * (z - Z)];
+            for (int i = 0; i < length; ++i) {
+                if (src[i] != EMPTY) {
+                    dst[i] = src[i];
+                }
             }
-
-            setBlockAt(pos.x - X, pos.y, pos.z - Z, block.first);
         }
     }
 }
 
-void Chunk::generateTerrainColumn(int cx, int cz)
+void Chunk::generateTerrainColumn(int cx, int cz, const ColumnClimate &climate, const CaveField &caves)
 {
     // absolute xz coordinates
     int x = cx + X;
@@ -73,14 +105,8 @@ void Chunk::generateTerrainColumn(int cx, int cz)
         setBlockAt(cx, y, cz, WATER);
     }
 
-    // overall stuff
-    auto blends = getHeightHumidityBlend(x, z);
-    float heightBlend = blends.first;
-    float humidityBlend = blends.second;
-
-    float oceanWeight = getOceanWeight(x, z);
-
-    int terrainY = getTerrainHeight(x, z, heightBlend, humidityBlend, oceanWeight);
+    // overall stuff, precomputed for the whole zone
+    int terrainY = climate.terrainHeight;
 
     // generate stone blocks by default
     for (int y = 0; y <= terrainY; ++y) {
@@ -88,9 +114,7 @@ void Chunk::generateTerrainColumn(int cx, int cz)
     }
 
     // add top blocks depending on biome
-    Biome biome = getBiome(heightBlend, humidityBlend, oceanWeight);
-
-    switch (biome) {
+    switch (climate.biome) {
         case ARCHIPELAGO: {
             if (terrainY >= 138) {
                 setBlockAt(cx, terrainY, cz, LEAF);
@@ -128,27 +152,11 @@ void Chunk::generateTerrainColumn(int cx, int cz)
     // cave systems
     float spaghettiMask = Noise::perlin(glm::vec2(x, z) * 0.01f, 1.f) * 0.5f + 0.5f;
     float cheeseMask = Noise::perlin(glm::vec2(x, z) * 0.01f + glm::vec2(1023), 1.f) * 0.5f + 0.5f;
-    for (int y = 0; y < 128; ++y) {
-        // blend to top
-        float mappedHeight = (y + 3.f) / (128.f - 3.f);
-        float heightClip = (glm::smoothstep(0.75f, 1.0f, mappedHeight) + glm::smoothstep(0.75f, 1.f, 1.f - y));
-
-        // edges of noise and such (like spaghetti)
-        float spaghettiCaveCarve = Noise::perlin(glm::vec3(x, y, z), 0.03f);
-        float spaghettiFill = glm::mix(0.085f, 0.13f, spaghettiMask);
-        float spaghettiSdf = glm::mix(-spaghettiFill, 1.f - spaghettiFill, glm::abs(spaghettiCaveCarve));
-
-        // holes like swiss cheese
-        float cheeseCarve = Noise::perlin(glm::vec3(x, y, z) + glm::vec3(2309.363), 0.019f) * 0.5f + 0.5f;
-        float cheeseFill = glm::mix(0.075f, 0.12f, cheeseMask);
-        float cheeseSdf = glm::mix(-cheeseFill, 1.f - cheeseFill, cheeseCarve);
-
-        float mergeRadius = 0.045f;
-        glm::vec2 mergeVec(spaghettiSdf, cheeseSdf);
-        mergeVec = glm::min(mergeVec, glm::vec2(0));
-        float caveCarve = glm::length(mergeVec) - mergeRadius;
-
-        if (caveCarve < -heightClip) {
+    // the water and the snow cap are the only blocks above terrainY
+    int columnTop = glm::max(137, climate.biome == MOUNTAINS ? terrainY + 1 : terrainY);
+    std::pair<int, int> caveBounds = CaveField::carveBounds(columnTop);
+    for (int y = caveBounds.first; y < caveBounds.second; ++y) {
+        if (caves.carves(cx, y, cz, spaghettiMask, cheeseMask)) {
             setBlockAt(cx, y, cz, y < 24 ? LAVA : EMPTY);
         }
     }
@@ -158,26 +166,29 @@ void Chunk::generateTerrainColumn(int cx, int cz)
 
 std::pair<float, float> Chunk::getHeightHumidityBlend(int x, int z)
 {
-    float heightBlend = glm::smoothstep(0.4f, 0.6f, Noise::fbm(x * 0.004f + 63.841f, z * 0.004f + 83.4517f));
-    float humidityBlend = glm::smoothstep(0.4f, 0.6f, Noise::fbm(x * 0.004f, z * 0.004f));
+    float heightBlend = glm::smoothstep(0.4f, 0.6f, TerrainNoise::layer(TerrainNoise::HEIGHT_BLEND).sample(x, z));
+    float humidityBlend = glm::smoothstep(0.4f, 0.6f, TerrainNoise::layer(TerrainNoise::HUMIDITY_BLEND).sample(x, z));
     return std::make_pair(heightBlend, humidityBlend);
 }
 
 float Chunk::getOceanWeight(int x, int z)
 {
-    return glm::smoothstep(0.45f, 0.65f, Noise::fbm(x * 0.001f, z * 0.001f));
+    return glm::smoothstep(0.45f, 0.65f, TerrainNoise::layer(TerrainNoise::OCEAN_WEIGHT).sample(x, z));
 }
 
-int Chunk::getTerrainHeight(int x, int z, float heightBlend, float humidityBlend, float oceanWeight)
+// Blends the sampled terrain noise layers of one column into its height
+static int blendTerrainHeight(float grassCells, float grassDetail, float mountain1, float mountain2,
+                              float archipelagoBig, float archipelagoSmall, float desert,
+                              float heightBlend, float humidityBlend, float oceanWeight)
 {
     // -- GRASSLAND --
-    float grassLandY = glm::mix(138.f, 166.f, abs(Noise::worley(glm::vec2(x, z), 0.01f)) +
-                                 Noise::fbm((x)* 0.05, (z)* 0.05) * 0.06);
+    float grassLandY = glm::mix(138.f, 166.f, abs(grassCells) +
+                                 grassDetail * 0.06);
 
     // -- MOUNTAINS --
-    float my1noise = Noise::fbm((x)* 0.005, (z)* 0.005);
+    float my1noise = mountain1;
     float mountainY1 = glm::mix(0.65f, 0.9f, my1noise * my1noise);
-    float my2noise = Noise::fbm((x + 9000)* 0.005, (z + 9000)* 0.005);
+    float my2noise = mountain2;
     float mountainY2 = glm::mix(0.65f, 0.9f, my2noise * my2noise);
 
     // Chooses the highest mountain
@@ -185,12 +196,12 @@ int Chunk::getTerrainHeight(int x, int z, float heightBlend, float humidityBlend
     mountainY *= 255.f;
 
     // -- ARCHIPELAGO --
-    float archipelagoYBig = glm::mix(114.f, 185.f, glm::smoothstep(0.2f, 1.f, Noise::perlin(glm::vec2(x, z), 0.02f) * 0.5f + 0.5f));
-    float archipelagoYSmall = glm::mix(0.f, 13.f, Noise::perlin(glm::vec2(x, z), 0.1f) * 0.5f + 0.5f);
+    float archipelagoYBig = glm::mix(114.f, 185.f, glm::smoothstep(0.2f, 1.f, archipelagoBig * 0.5f + 0.5f));
+    float archipelagoYSmall = glm::mix(0.f, 13.f, archipelagoSmall * 0.5f + 0.5f);
     float archipelagoY = archipelagoYBig + archipelagoYSmall;
 
     // -- DESERT --
-    float desertY = glm::mix(139.f, 165.f, Noise::fbm(x * 0.003f + 1593.2f, z * 0.003f + 234.3f));
+    float desertY = glm::mix(139.f, 165.f, desert);
 
     float humidsBlend = glm::mix(grassLandY, archipelagoY, heightBlend);
     float drysBlend = glm::mix(desertY, mountainY, heightBlend);
@@ -201,6 +212,16 @@ int Chunk::getTerrainHeight(int x, int z, float heightBlend, float humidityBlend
     return glm::floor(terrainHeightWithOcean);
 }
 
+int Chunk::getTerrainHeight(int x, int z, float heightBlend, float humidityBlend, float oceanWeight)
+{
+    using namespace TerrainNoise;
+    return blendTerrainHeight(layer(GRASS_CELLS).sample(x, z), layer(GRASS_DETAIL).sample(x, z),
+                              layer(MOUNTAIN_1).sample(x, z), layer(MOUNTAIN_2).sample(x, z),
+                              layer(ARCHIPELAGO_BIG).sample(x, z), layer(ARCHIPELAGO_SMALL).sample(x, z),
+                              layer(DESERT_DUNES).sample(x, z),
+                              heightBlend, humidityBlend, oceanWeight);
+}
+
 int Chunk::getTerrainHeight(int x, int z)
 {
     auto blends = getHeightHumidityBlend(x, z);
@@ -208,6 +229,46 @@ int Chunk::getTerrainHeight(int x, int z)
     return getTerrainHeight(x, z, blends.first, blends.second, oceanWeight);
 }
 
+void Chunk::getHeightHumidityBlendRow(int x, int z, int n, float *heightBlend, float *humidityBlend)
+{
+    TerrainNoise::layer(TerrainNoise::HEIGHT_BLEND).sampleRow(x, z, n, heightBlend);
+    TerrainNoise::layer(TerrainNoise::HUMIDITY_BLEND).sampleRow(x, z, n, humidityBlend);
+    for (int i = 0; i < n; ++i) {
+        heightBlend[i] = glm::smoothstep(0.4f, 0.6f, heightBlend[i]);
+        humidityBlend[i] = glm::smoothstep(0.4f, 0.6f, humidityBlend[i]);
+    }
+}
+
+void Chunk::getOceanWeightRow(int x, int z, int n, float *oceanWeight)
+{
+    TerrainNoise::layer(TerrainNoise::OCEAN_WEIGHT).sampleRow(x, z, n, oceanWeight);
+    for (int i = 0; i < n; ++i) {
+        oceanWeight[i] = glm::smoothstep(0.45f, 0.65f, oceanWeight[i]);
+    }
+}
+
+void Chunk::getTerrainHeightRow(int x, int z, int n, const float *heightBlend, const float *humidityBlend,
+                                const float *oceanWeight, int *terrainHeight)
+{
+    using namespace TerrainNoise;
+    // evaluate every noise layer across the row first
+    std::vector<float> grassCells(n), grassDetail(n), mountain1(n), mountain2(n),
+            archipelagoBig(n), archipelagoSmall(n), desert(n);
+    layer(GRASS_CELLS).sampleRow(x, z, n, grassCells.data());
+    layer(GRASS_DETAIL).sampleRow(x, z, n, grassDetail.data());
+    layer(MOUNTAIN_1).sampleRow(x, z, n, mountain1.data());
+    layer(MOUNTAIN_2).sampleRow(x, z, n, mountain2.data());
+    layer(ARCHIPELAGO_BIG).sampleRow(x, z, n, archipelagoBig.data());
+    layer(ARCHIPELAGO_SMALL).sampleRow(x, z, n, archipelagoSmall.data());
+    layer(DESERT_DUNES).sampleRow(x, z, n, desert.data());
+
+    for (int i = 0; i < n; ++i) {
+        terrainHeight[i] = blendTerrainHeight(grassCells[i], grassDetail[i], mountain1[i], mountain2[i],
+                                              archipelagoBig[i], archipelagoSmall[i], desert[i],
+                                              heightBlend[i], humidityBlend[i], oceanWeight[i]);
+    }
+}
+
 Biome Chunk::getBiome(float height, float humidity, float oceanWeight)
 {
     if (oceanWeight > 0.1f) {
@@ -234,6 +295,25 @@ Biome Chunk::getBiome(int x, int z)
     return getBiome(blends.first, blends.second, oceanWeight);
 }
 
+bool Chunk::getVoronoiPoint(int xCell, int zCell, float cellSize, float frequency, glm::ivec2 &pos, float &seed)
+{
+    float hasPointChance = Noise::rand(glm::vec2(xCell, zCell));
+
+    // skip this one if rand value doesn't hit frequency probability
+    if (hasPointChance > frequency) {
+        return false;
+    }
+
+    float xFrac = Noise::rand(glm::vec2(xCell * 1235.231f, zCell * 631.613f));
+    float zFrac = Noise::rand(glm::vec2(xCell * 838.513f, zCell * 351.345f));
+
+    seed = Noise::rand(glm::vec2(xCell * 823.156f, zCell * 235.456f));
+
+    pos.x = glm::floor((xCell * 1.f + xFrac) * cellSize);
+    pos.y = glm::floor((zCell * 1.f + zFrac) * cellSize);
+    return true;
+}
+
 std::vector<std::pair<glm::ivec2, float>> Chunk::getVoronoiPoints(int sx, int sz, int ex, int ez, float cellSize, float frequency)
 {
     std::vector<std::pair<glm::ivec2, float>> points;
@@ -246,24 +326,15 @@ std::vector<std::pair<glm::ivec2, float>> Chunk::getVoronoiPoints(int sx, int sz
 
     for (int xCell = xStartCell; xCell <= xEndCell; ++xCell) {
         for (int zCell = zStartCell; zCell <= zEndCell; ++zCell) {
-            float hasPointChance = Noise::rand(glm::vec2(xCell, zCell));
-
-            // skip this one if rand value doesn't hit frequency probability
-            if (hasPointChance > frequency) {
+            glm::ivec2 pos;
+            float randValue;
+            if (!getVoronoiPoint(xCell, zCell, cellSize, frequency, pos, randValue)) {
                 continue;
             }
 
-            float xFrac = Noise::rand(glm::vec2(xCell * 1235.231f, zCell * 631.613f));
-            float zFrac = Noise::rand(glm::vec2(xCell * 838.513f, zCell * 351.345f));
-
-            float randValue = Noise::rand(glm::vec2(xCell * 823.156f, zCell * 235.456f));
-
-            int xPos = glm::floor((xCell * 1.f + xFrac) * cellSize);
-            int zPos = glm::floor((zCell * 1.f + zFrac) * cellSize);
-
             // add our point, as long as it's in bounds.
-            if (xPos >= sx && xPos < ex && zPos >= sz && zPos < ez) {
-                points.push_back(std::make_pair(glm::ivec2(xPos, zPos), randValue));
+            if (pos.x >= sx && pos.x < ex && pos.y >= sz && pos.y < ez) {
+                points.push_back(std::make_pair(pos, randValue));
             }
         }
     }
@@ -271,53 +342,6 @@ std::vector<std::pair<glm::ivec2, float>> Chunk::getVoronoiPoints(int sx, int sz
     return points;
 }
 
-std::vector<uPtr<Structure>> Chunk::getStructures()
-{
-    std::vector<uPtr<Structure>> structures;
-
-    // pyramids
-    int pyramidRadius = 40;
-    auto pyramids = getVoronoiPoints(X - pyramidRadius, Z - pyramidRadius, X + WIDTH + pyramidRadius, Z + WIDTH + pyramidRadius, 160, 0.4f);
-    for (auto& pData : pyramids) {
-        Biome biome = getBiome(pData.first.x, pData.first.y);
-        if (biome != DESERT) continue;
-
-        structures.push_back(mkU<Pyramid>(pData.first, pData.second));
-    }
-
-    // trees
-    int treeRadius = 4;
-    auto trees = getVoronoiPoints(X - treeRadius, Z - treeRadius, X + WIDTH + treeRadius, Z + WIDTH + treeRadius, 10, 0.14f);
-    for (auto& tData : trees) {
-        Biome biome = getBiome(tData.first.x, tData.first.y);
-        if (biome != GRASS_LANDS) continue;
-
-        structures.push_back(mkU<Tree>(tData.first, tData.second));
-    }
-
-    // ice spikes
-    int iceSpikeRadius = 2;
-    auto iceSpikes = getVoronoiPoints(X - iceSpikeRadius, Z - iceSpikeRadius, X + WIDTH + iceSpikeRadius, Z + WIDTH + iceSpikeRadius, 13, 0.25f);
-    for (auto& spikeData : iceSpikes) {
-        Biome biome = getBiome(spikeData.first.x, spikeData.first.y);
-        if (biome != MOUNTAINS) continue;
-
-        structures.push_back(mkU<IceSpike>(spikeData.first, spikeData.second));
-    }
-
-    // lookouts
-    int lookoutRadius = 4;
-    auto lookouts = getVoronoiPoints(X - lookoutRadius, Z - lookoutRadius, X + WIDTH + lookoutRadius, Z + WIDTH + lookoutRadius, 16, 0.22f);
-    for (auto& lookout : lookouts) {
-        Biome biome = getBiome(lookout.first.x, lookout.first.y);
-        if (biome != ARCHIPELAGO) continue;
-
-        structures.push_back(mkU<Lookout>(lookout.first, lookout.second));
-    }
-
-    return structures;
-}
-
 const std::unordered_map<Direction, Direction, EnumHash> Chunk::oppositeDirection {
     {XPOS, XNEG},
     {XNEG, XPOS},
@@ -350,17 +374,16 @@ bool Chunk::isTransparent(BlockType block) {
             blockFaceUVs.at(block).at(XPOS).z < 1 && blockFaceUVs.at(block).at(XPOS).z > 0) ;
 }
 
-void Chunk::createVBOdata()
+void Chunk::markGenerated()
 {
-    std::vector<GLuint> idx_o, idx_t;
-    std::vector<glm::vec4> combined_o, combined_t;
-
-    // fill vectors
-    getInterleavedVBOdata(idx_o, combined_o, idx_t, combined_t);
-    bufferInterleavedVBOdata(idx_o, combined_o, idx_t, combined_t);
+    isGenerated = true;
 }
 
 // Does bounds checking with at()
+const std::array<BlockType, 65536>& Chunk::getBlocks() const {
+    return m_blocks;
+}
+
 BlockType Chunk::getBlockAt(unsigned int x, unsigned int y, unsigned int z) const {
     return m_blocks.at(x + WIDTH * y + WIDTH * HEIGHT * z);
 }
@@ -382,6 +405,12 @@ std::vector<Chunk*> Chunk::getNeighbors()
     return out;
 }
 
+Chunk* Chunk::getNeighbor(Direction dir) const
+{
+    auto neighbor = m_neighbors.find(dir);
+    return neighbor == m_neighbors.end() ? nullptr : neighbor->second;
+}
+
 // Does bounds checking with at()
 void Chunk::setBlockAt(unsigned int x, unsigned int y, unsigned int z, BlockType t) {
     m_blocks.at(x + WIDTH * y + WIDTH * HEIGHT * z) = t;
@@ -507,7 +536,7 @@ const std::array<BlockFaceData, 6> Chunk::blockFaces {
                                               VertexData(glm::vec4(0, 0, 1, 1), glm::vec2(0, BLK_UV))),
 };
 
-void Chunk::generateFace(std::vector<GLuint>& idx, std::vector<glm::vec4>& combined,
+void Chunk::generateFace(std::vector<unsigned int>& idx, std::vector<glm::vec4>& combined,
                          glm::vec3& pos, const BlockFaceData& faceData, BlockType blockType)
 {
     // there are 6 indices, but 4 vertices per block face
@@ -537,9 +566,88 @@ void Chunk::generateFace(std::vector<GLuint>& idx, std::vector<glm::vec4>& combi
     }
 }
 
-void Chunk::getInterleavedVBOdata(std::vector<GLuint>& idx_o, std::vector<glm::vec4>& combined_o,
-                                  std::vector<GLuint>& idx_t, std::vector<glm::vec4>& combined_t)
+void Chunk::getSectionConnectivity(std::array<SectionConnectivity, SECTION_COUNT> &out) const
+{
+    // isSolid does two map lookups, so look each block type up once
+    static const std::array<bool, 256> opaque = [] {
+        std::array<bool, 256> table;
+        for (int b = 0; b < 256; ++b) {
+            table[b] = isSolid(static_cast<BlockType>(b));
+        }
+        return table;
+    }();
+
+    const int cells = WIDTH * SECTION_HEIGHT * WIDTH;
+    // cell index offsets of the neighbor in each Direction
+    const int steps[6] = {1, -1, WIDTH, -WIDTH, WIDTH * SECTION_HEIGHT, -WIDTH * SECTION_HEIGHT};
+    std::array<bool, WIDTH * SECTION_HEIGHT * WIDTH> visited;
+    std::vector<int> stack;
+    stack.reserve(cells);
+
+    for (int section = 0; section < SECTION_COUNT; ++section) {
+        SectionConnectivity &faces = out[section];
+        faces.fill(0);
+        int yBase = section * SECTION_HEIGHT;
+
+        // cell i is the block at x = i % W, y = yBase + (i / W) % H, z = i / (W * H),
+        // which keeps the same x-fastest order as m_blocks
+        int open = 0;
+        for (int i = 0; i < cells; ++i) {
+            int x = i % WIDTH, y = i / WIDTH % SECTION_HEIGHT, z = i / (WIDTH * SECTION_HEIGHT);
+            visited[i] = opaque[m_blocks[x + WIDTH * (yBase + y) + WIDTH * HEIGHT * z]];
+            open += !visited[i];
+        }
+        if (open == 0) {
+            continue;
+        }
+        if (open == cells) {
+            faces.fill(0x3f);
+            continue;
+        }
+
+        for (int seed = 0; seed < cells; ++seed) {
+            if (visited[seed]) {
+                continue;
+            }
+            // flood fill this pocket of open blocks, noting every face it touches
+            unsigned char touched = 0;
+            visited[seed] = true;
+            stack.push_back(seed);
+            while (!stack.empty()) {
+                int i = stack.back();
+                stack.pop_back();
+                int x = i % WIDTH, y = i / WIDTH % SECTION_HEIGHT, z = i / (WIDTH * SECTION_HEIGHT);
+                const bool atFace[6] = {x == WIDTH - 1, x == 0, y == SECTION_HEIGHT - 1, y == 0, z == WIDTH - 1, z == 0};
+                for (int d = 0; d < 6; ++d) {
+                    if (atFace[d]) {
+                        touched |= 1 << d;
+                    } else if (!visited[i + steps[d]]) {
+                        visited[i + steps[d]] = true;
+                        stack.push_back(i + steps[d]);
+                    }
+                }
+            }
+            for (int a = 0; a < 6; ++a) {
+                if (touched & (1 << a)) {
+                    faces[a] |= touched;
+                }
+            }
+        }
+    }
+}
+
+void Chunk::getInterleavedVBOdata(std::vector<unsigned int>& idx_o, std::vector<glm::vec4>& combined_o,
+                                  std::vector<unsigned int>& idx_t, std::vector<glm::vec4>& combined_t)
 {
+    // A neighbor whose BDWorker hasn't handed it over may still be writing
+    // its blocks, so treat it as missing. Its border gets remeshed when its
+    // blocks land.
+    std::unordered_map<Direction, Chunk*, EnumHash> neighbors;
+    for (auto& n : m_neighbors)
+    {
+        neighbors[n.first] = n.second != nullptr && n.second->isGenerated ? n.second : nullptr;
+    }
+
     // iterate through all blocks
     for (int x = 0; x < WIDTH; ++x)
     {
@@ -552,7 +660,7 @@ void Chunk::getInterleavedVBOdata(std::vector<GLuint>& idx_o, std::vector<glm::v
                 if (!isSolid(blockType) && !isTransparent(blockType)) { continue; }
 
                 // use transparent or opaque depending on transparency
-                std::vector<GLuint>& idx = isTransparent(blockType) ? idx_t : idx_o;
+                std::vector<unsigned int>& idx = isTransparent(blockType) ? idx_t : idx_o;
                 std::vector<glm::vec4>& combined = isTransparent(blockType) ? combined_t : combined_o;
 
                 // if solid, go through faces and check for solid block
@@ -569,10 +677,9 @@ void Chunk::getInterleavedVBOdata(std::vector<GLuint>& idx_o, std::vector<glm::v
                     // if we're OOB in x or z direction, get neighbor chunk
                     if (posX < 0 || posX >= WIDTH || posZ < 0 || posZ >= WIDTH)
                     {
-                        auto& neighborChunk = m_neighbors.at(faceData.direction);
+                        auto& neighborChunk = neighbors.at(faceData.direction);
 
-                        // if neighbor chunk DNE, set block type to stone
-                        // TODO: update this check to reflect how we actually know if chunks have generated blocks
+                        // if neighbor chunk DNE or isn't generated yet, set block type to stone
                         if (neighborChunk == nullptr)
                         { neighborBlockType = STONE; }
 
@@ -613,30 +720,39 @@ void Chunk::getInterleavedVBOdata(std::vector<GLuint>& idx_o, std::vector<glm::v
     }
 }
 
-void Chunk::bufferInterleavedVBOdata(std::vector<GLuint>& idxOpq, std::vector<glm::vec4>& combinedOpq,
-                                     std::vector<GLuint>& idxTra, std::vector<glm::vec4>& combinedTra)
-{
-    m_countOpq = idxOpq.size();
-    m_countTra = idxTra.size();
-
-    generateIdxOpq();
-    mp_context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_bufIdxOpq);
-    mp_context->glBufferData(GL_ELEMENT_ARRAY_BUFFER, idxOpq.size() * sizeof(GLuint), idxOpq.data(), GL_STATIC_DRAW);
-    generatePosOpq();
-    mp_context->glBindBuffer(GL_ARRAY_BUFFER, m_bufPosOpq);
-    mp_context->glBufferData(GL_ARRAY_BUFFER, combinedOpq.size() * sizeof(glm::vec4), combinedOpq.data(), GL_STATIC_DRAW);
-
-    generateIdxTra();
-    mp_context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_bufIdxTra);
-    mp_context->glBufferData(GL_ELEMENT_ARRAY_BUFFER, idxTra.size() * sizeof(GLuint), idxTra.data(), GL_STATIC_DRAW);
-    generatePosTra();
-    mp_context->glBindBuffer(GL_ARRAY_BUFFER, m_bufPosTra);
-    mp_context->glBufferData(GL_ARRAY_BUFFER, combinedTra.size() * sizeof(glm::vec4), combinedTra.data(), GL_STATIC_DRAW);
+void Chunk::getFaceCenters(const std::vector<glm::vec4>& combined, std::vector<glm::vec3>& centers) {
+    // 3 vec4s per vertex, 4 vertices per face, and vertices 0 and 2 are
+    // opposite corners
+    centers.resize(combined.size() / 12);
+    for (size_t i = 0; i < centers.size(); ++i) {
+        centers[i] = glm::vec3(combined[i * 12] + combined[i * 12 + 6]) * 0.5f;
+    }
+}
 
-    isBuffered = true;
+void Chunk::sortFacesBackToFront(std::vector<unsigned int>& idx, const std::vector<glm::vec3>& centers, glm::vec3 eye) {
+    std::vector<std::pair<float, unsigned int>> order(centers.size());
+    for (size_t i = 0; i < centers.size(); ++i) {
+        glm::vec3 d = centers[i] - eye;
+        order[i] = {glm::dot(d, d), static_cast<unsigned int>(i)};
+    }
+    std::sort(order.begin(), order.end(), [](const std::pair<float, unsigned int> &a, const std::pair<float, unsigned int> &b) {
+        return a.first > b.first;
+    });
+    // the same two triangles generateFace makes, in the new face order
+    idx.resize(centers.size() * 6);
+    for (size_t i = 0; i < order.size(); ++i) {
+        unsigned int v = order[i].second * 4;
+        unsigned int *face = &idx[i * 6];
+        face[0] = v;
+        face[1] = v + 1;
+        face[2] = v + 2;
+        face[3] = v;
+        face[4] = v + 2;
+        face[5] = v + 3;
+    }
 }
 
 ChunkVBOdata::ChunkVBOdata(Chunk* c) : mp_chunk(c),
     m_vboDataOpaque{}, m_vboDataTransparent{},
-    m_idxDataOpaque{}, m_idxDataTransparent{}
+    m_idxDataOpaque{}, m_idxDataTransparent{}, m_sectionConnectivity{}
 {}
@@ -1,15 +1,22 @@
 #pragma once
 
 #include "smartpointerhelp.h"
-#include "drawable.h"
-#include "texture.h"
+#include "glm_includes.h"
+#include "arenaallocator.h"
 
 #include <array>
 #include <unordered_map>
 #include <cstddef>
+#include <atomic>
 #include <QMutex>
 
 class Structure;
+class StructureStencil;
+class StructureRegistry;
+class ClimateMap;
+struct ColumnClimate;
+class CaveField;
+class ChunkArena;
 
 
 #define BLK_UV 0.03125f
@@ -33,6 +40,15 @@ enum Direction : unsigned char
     XPOS, XNEG, YPOS, YNEG, ZPOS, ZNEG
 };
 
+// Chunks are split into 16-block-tall sections for occlusion culling
+#define SECTION_HEIGHT 16
+#define SECTION_COUNT 16
+
+// How the faces of one section are joined through non-opaque blocks:
+// bit b of faces[a] is set when some path of non-opaque blocks inside the
+// section runs from face a to face b. Faces are indexed by Direction.
+typedef std::array<unsigned char, 6> SectionConnectivity;
+
 struct VertexData {
     glm::vec4 pos;
     glm::vec2 uv;
@@ -71,10 +87,11 @@ struct EnumHash {
 // recomputing its VBO data faster by not having to
 // render all the world at once, while also not having
 // to render the world block by block.
-class Chunk : public Drawable
+class Chunk
 {
 public:
-    Chunk(OpenGLContext* context, int x, int z);
+    // Meshes are buffered into arena; chunks without one can't be drawn
+    Chunk(int x, int z, ChunkArena* arena = nullptr);
     ~Chunk();
 
     const int X, Z;
@@ -88,11 +105,25 @@ public:
     static bool isSolid(BlockType block);
     static bool isTransparent(BlockType block) ;
 
-    // stores all interleaved VBO data in pos
-    void createVBOdata() override;
-
-    void generateTerrain();
-    void generateTerrainColumn(int chunkX, int chunkZ);
+    // stores all interleaved VBO data in the arena. This and everything
+    // else that touches the arena is in chunkupload.cpp, which the
+    // headless tools don't link.
+    void createVBOdata();
+    // Frees this chunk's space in the arena
+    void destroyVBOdata();
+
+    // Fills the chunk with terrain and structures. Reads column climates from
+    // the given zone map, or computes a map for just this chunk if none covers it.
+    // Structures come from the given registry, or one used only by this chunk.
+    void generateTerrain(const ClimateMap *climate = nullptr, StructureRegistry *structures = nullptr);
+    // The two stages of generateTerrain. The climate map must cover the whole chunk.
+    void generateColumns(const ClimateMap &climate);
+    void generateStructures(const ClimateMap &climate, StructureRegistry &structures);
+    void generateTerrainColumn(int chunkX, int chunkZ, const ColumnClimate &climate, const CaveField &caves);
+    // Marks the blocks as filled in, for chunks generated without a
+    // Terrain. A Terrain marks its chunks once their BDWorker hands them
+    // over; until then neighbors mesh against them as if they were missing.
+    void markGenerated();
 
     // terrain generation helpers
     static std::pair<float, float> getHeightHumidityBlend(int x, int z);
@@ -101,19 +132,33 @@ public:
     static int getTerrainHeight(int x, int z); // calls prev functions!
     static Biome getBiome(float height, float humidity, float oceanWeight);
     static Biome getBiome(int x, int z); // calls prev functions!
+    // batched versions of the helpers above, for the n columns starting at
+    // (x, z) and running along +x. Results match the per-column versions exactly.
+    static void getHeightHumidityBlendRow(int x, int z, int n, float *heightBlend, float *humidityBlend);
+    static void getOceanWeightRow(int x, int z, int n, float *oceanWeight);
+    static void getTerrainHeightRow(int x, int z, int n, const float *heightBlend, const float *humidityBlend,
+                                    const float *oceanWeight, int *terrainHeight);
 
     // structure generation helpers
+    // The point of one Voronoi cell, if it has one, and its random seed
+    static bool getVoronoiPoint(int xCell, int zCell, float cellSize, float frequency, glm::ivec2 &pos, float &seed);
     static std::vector<std::pair<glm::ivec2, float>> getVoronoiPoints(int sx, int sz, int ex, int ez, float cellSize, float frequency);
-    std::vector<uPtr<Structure>> getStructures();
 
+    // Every block of the chunk, indexed by x + WIDTH * y + WIDTH * HEIGHT * z
+    const std::array<BlockType, 65536>& getBlocks() const;
     BlockType getBlockAt(unsigned int x, unsigned int y, unsigned int z) const;
     BlockType getBlockAt(int x, int y, int z) const;
     std::vector<Chunk*> getNeighbors();
+    // The neighboring Chunk in the given horizontal direction, or nullptr
+    Chunk* getNeighbor(Direction dir) const;
 
     void setBlockAt(unsigned int x, unsigned int y, unsigned int z, BlockType t);
     void linkNeighbor(uPtr<Chunk>& neighbor, Direction dir);
 
 private:
+    // Copies the part of a structure stencil rooted at root that lies in this chunk
+    void stampStencil(const StructureStencil &stencil, glm::ivec3 root);
+
     // All of the blocks contained within this Chunk
     std::array<BlockType, 65536> m_blocks;
 
@@ -129,19 +174,59 @@ private:
     const static std::array<BlockFaceData, 6> blockFaces;
 
     // Add vertex data for one specified face to the given VBO data vector references
-    static void generateFace(std::vector<GLuint>& idx, std::vector<glm::vec4>& combined,
+    static void generateFace(std::vector<unsigned int>& idx, std::vector<glm::vec4>& combined,
                              glm::vec3& pos, const BlockFaceData& faceData, BlockType blockType);
 
-    // Fills VBO data vectors with interleaved data
-    void getInterleavedVBOdata(std::vector<GLuint>& idx_o, std::vector<glm::vec4>& combined_o,
-                               std::vector<GLuint>& idx_t, std::vector<glm::vec4>& combined_t);
+    // Flood fills every section's non-opaque blocks to find which of its
+    // faces can see each other. Done alongside meshing, on the same thread.
+    void getSectionConnectivity(std::array<SectionConnectivity, SECTION_COUNT> &out) const;
 
-    // Buffers the given data vectors to VBOs for the GPU
-    void bufferInterleavedVBOdata(std::vector<GLuint>& idx_o, std::vector<glm::vec4>& combined_o,
-                                  std::vector<GLuint>& idx_t, std::vector<glm::vec4>& combined_t);
+    // Fills VBO data vectors with interleaved data
+    void getInterleavedVBOdata(std::vector<unsigned int>& idx_o, std::vector<glm::vec4>& combined_o,
+                               std::vector<unsigned int>& idx_t, std::vector<glm::vec4>& combined_t);
+
+    // The center of each face in the given VBO data. Every face is a quad
+    // of 4 vertices, as generateFace makes them.
+    static void getFaceCenters(const std::vector<glm::vec4>& combined, std::vector<glm::vec3>& centers);
+    // Rewrites idx so the faces with the given centers are drawn
+    // farthest from eye first
+    static void sortFacesBackToFront(std::vector<unsigned int>& idx, const std::vector<glm::vec3>& centers, glm::vec3 eye);
+    // Re-sorts the buffered transparent faces for a camera at eye
+    // (in world space), rewriting only their indices in the arena
+    void sortTransparentFaces(glm::vec3 eye);
+
+    // Moves the given data vectors' positions into world space and copies
+    // them into the arena for the GPU. centers_t are the transparent faces'
+    // centers if they were sorted, kept for re-sorting, or empty.
+    void bufferInterleavedVBOdata(std::vector<unsigned int>& idx_o, std::vector<glm::vec4>& combined_o,
+                                  std::vector<unsigned int>& idx_t, std::vector<glm::vec4>& combined_t,
+                                  std::vector<glm::vec3>& centers_t);
     QMutex chunkLock;
 
     bool isBuffered;
+    // Have this chunk's blocks been filled in? Chunks waiting on a BDWorker
+    // are already in the Terrain but read as missing until they are.
+    // Only set on the thread that owns the chunk, but VBOWorkers meshing
+    // a neighbor read it to know whether this chunk's blocks are safe to
+    // look at.
+    std::atomic<bool> isGenerated;
+    // The arena holding this chunk's meshes, and where in it they are
+    ChunkArena* mp_arena;
+    ArenaMesh m_meshOpq, m_meshTra;
+    // Index counts of the buffered meshes, or -1 while there are none
+    int m_countOpq, m_countTra;
+    // Chunk-space center of each buffered transparent face, kept so they
+    // can be re-sorted without remeshing. Empty unless the faces were
+    // sorted when the chunk was meshed.
+    std::vector<glm::vec3> m_faceCentersTra;
+    // Connectivity of each section as of the buffered mesh
+    std::array<SectionConnectivity, SECTION_COUNT> m_sectionConnectivity;
+    // Height range, in blocks, spanned by the buffered mesh's vertices.
+    // m_meshMinY > m_meshMaxY when the mesh has no faces at all.
+    int m_meshMinY, m_meshMaxY;
+    // Index of this chunk's entry in the Terrain's draw entries,
+    // or -1 while it has none
+    int m_drawEntry;
 
     friend class Terrain;
     friend class BDWorker;
@@ -151,7 +236,11 @@ private:
 struct ChunkVBOdata {
     Chunk* mp_chunk;
     std::vector<glm::vec4> m_vboDataOpaque, m_vboDataTransparent;
-    std::vector<GLuint> m_idxDataOpaque, m_idxDataTransparent;
+    std::vector<unsigned int> m_idxDataOpaque, m_idxDataTransparent;
+    // Chunk-space centers of the transparent faces, only filled when the
+    // worker sorted them
+    std::vector<glm::vec3> m_faceCentersTransparent;
+    std::array<SectionConnectivity, SECTION_COUNT> m_sectionConnectivity;
 
     ChunkVBOdata(Chunk* c);
 };
@@ -0,0 +1,167 @@
+#include "chunkarena.h"
+#include "drawable.h"
+#include <algorithm>
+
+// Every vertex is a position, a normal and a UV, one vec4 each
+static const GLsizeiptr VERTEX_BYTES = 3 * sizeof(glm::vec4);
+
+void ArenaDrawBatch::clear() {
+    counts.clear();
+    indexOffsets.clear();
+    baseVertices.clear();
+}
+
+void ArenaDrawBatch::add(const ArenaMesh &mesh) {
+    counts.push_back(static_cast<GLsizei>(mesh.indices.size));
+    indexOffsets.push_back(reinterpret_cast<const void*>(static_cast<size_t>(mesh.indices.offset) * sizeof(GLuint)));
+    baseVertices.push_back(static_cast<GLint>(mesh.vertices.offset));
+}
+
+int ArenaDrawBatch::size() const {
+    return static_cast<int>(counts.size());
+}
+
+ChunkArena::ChunkArena(OpenGLContext *context)
+    : mp_context(context), m_vertexBuffer(-1), m_indexBuffer(-1), m_vao(-1), m_created(false),
+      m_vertices(ARENA_INITIAL_CHUNKS * ARENA_VERTICES_PER_CHUNK),
+      m_indices(ARENA_INITIAL_CHUNKS * ARENA_INDICES_PER_CHUNK), m_grows(0)
+{}
+
+void ChunkArena::create() {
+    mp_context->glGenBuffers(1, &m_vertexBuffer);
+    mp_context->glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer);
+    mp_context->glBufferData(GL_COPY_WRITE_BUFFER, m_vertices.capacity() * VERTEX_BYTES, nullptr, GL_STATIC_DRAW);
+    mp_context->glGenBuffers(1, &m_indexBuffer);
+    mp_context->glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer);
+    mp_context->glBufferData(GL_COPY_WRITE_BUFFER, m_indices.capacity() * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+    mp_context->glGenVertexArrays(1, &m_vao);
+    m_created = true;
+    setUpVAO();
+}
+
+void ChunkArena::destroy() {
+    if (m_created) {
+        m_created = false;
+        mp_context->glDeleteVertexArrays(1, &m_vao);
+        mp_context->glDeleteBuffers(1, &m_vertexBuffer);
+        mp_context->glDeleteBuffers(1, &m_indexBuffer);
+    }
+}
+
+void ChunkArena::growBuffer(GLuint &buffer, GLsizeiptr oldBytes, GLsizeiptr newBytes) {
+    GLuint grown;
+    mp_context->glGenBuffers(1, &grown);
+    mp_context->glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    mp_context->glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_STATIC_DRAW);
+    mp_context->glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    mp_context->glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+    mp_context->glDeleteBuffers(1, &buffer);
+    buffer = grown;
+}
+
+void ChunkArena::growTo(unsigned int vertices, unsigned int indices) {
+    bool grown = false;
+    if (vertices > m_vertices.capacity()) {
+        if (m_created) {
+            growBuffer(m_vertexBuffer, m_vertices.capacity() * VERTEX_BYTES, vertices * VERTEX_BYTES);
+        }
+        m_vertices.grow(vertices);
+        grown = true;
+    }
+    if (indices > m_indices.capacity()) {
+        if (m_created) {
+            growBuffer(m_indexBuffer, m_indices.capacity() * sizeof(GLuint), indices * sizeof(GLuint));
+        }
+        m_indices.grow(indices);
+        grown = true;
+    }
+    if (grown && m_created) {
+        setUpVAO();
+    }
+}
+
+void ChunkArena::reserve(int chunks) {
+    growTo(chunks * ARENA_VERTICES_PER_CHUNK, chunks * ARENA_INDICES_PER_CHUNK);
+}
+
+void ChunkArena::setUpVAO() {
+    // Whatever VAO was bound is restored after
+    GLint prevVAO;
+    mp_context->glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &prevVAO);
+    mp_context->glBindVertexArray(m_vao);
+    mp_context->glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    mp_context->glEnableVertexAttribArray(ATTR_POS_LOCATION);
+    mp_context->glVertexAttribPointer(ATTR_POS_LOCATION, 4, GL_FLOAT, false, VERTEX_BYTES, (void*)0);
+    mp_context->glEnableVertexAttribArray(ATTR_NOR_LOCATION);
+    mp_context->glVertexAttribPointer(ATTR_NOR_LOCATION, 4, GL_FLOAT, false, VERTEX_BYTES, (void*)sizeof(glm::vec4));
+    mp_context->glEnableVertexAttribArray(ATTR_UV_LOCATION);
+    mp_context->glVertexAttribPointer(ATTR_UV_LOCATION, 4, GL_FLOAT, false, VERTEX_BYTES, (void*)(sizeof(glm::vec4) * 2));
+    mp_context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    mp_context->glBindVertexArray(prevVAO);
+}
+
+void ChunkArena::upload(ArenaMesh &mesh, const std::vector<glm::vec4> &combined, const std::vector<GLuint> &idx) {
+    if (!m_created) {
+        create();
+    }
+    release(mesh);
+    unsigned int vertexCount = static_cast<unsigned int>(combined.size() / 3);
+    unsigned int indexCount = static_cast<unsigned int>(idx.size());
+    if (vertexCount == 0 || indexCount == 0) {
+        return;
+    }
+
+    if (!m_vertices.allocate(vertexCount, mesh.vertices)) {
+        growTo(m_vertices.capacity() + std::max(m_vertices.capacity() / 2, vertexCount), 0);
+        m_vertices.allocate(vertexCount, mesh.vertices);
+        ++m_grows;
+    }
+    if (!m_indices.allocate(indexCount, mesh.indices)) {
+        growTo(0, m_indices.capacity() + std::max(m_indices.capacity() / 2, indexCount));
+        m_indices.allocate(indexCount, mesh.indices);
+        ++m_grows;
+    }
+
+    // Upload through the copy target so the bound VAO's index buffer is left alone
+    mp_context->glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer);
+    mp_context->glBufferSubData(GL_COPY_WRITE_BUFFER, mesh.vertices.offset * VERTEX_BYTES,
+                                vertexCount * VERTEX_BYTES, combined.data());
+    mp_context->glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer);
+    mp_context->glBufferSubData(GL_COPY_WRITE_BUFFER, mesh.indices.offset * sizeof(GLuint),
+                                indexCount * sizeof(GLuint), idx.data());
+}
+
+void ChunkArena::uploadIndices(const ArenaMesh &mesh, const std::vector<GLuint> &idx) {
+    if (mesh.indices.size == 0 || idx.size() != mesh.indices.size) {
+        return;
+    }
+    mp_context->glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer);
+    mp_context->glBufferSubData(GL_COPY_WRITE_BUFFER, mesh.indices.offset * sizeof(GLuint),
+                                idx.size() * sizeof(GLuint), idx.data());
+}
+
+void ChunkArena::release(ArenaMesh &mesh) {
+    m_vertices.free(mesh.vertices);
+    m_indices.free(mesh.indices);
+}
+
+void ChunkArena::bindVAO() {
+    mp_context->glBindVertexArray(m_vao);
+}
+
+ChunkArenaStats ChunkArena::getStats() const {
+    ChunkArenaStats stats;
+    stats.meshes = m_vertices.allocations();
+    stats.vertexCapacity = m_vertices.capacity();
+    stats.verticesUsed = m_vertices.used();
+    stats.indexCapacity = m_indices.capacity();
+    stats.indicesUsed = m_indices.used();
+    stats.vertexFreeBlocks = m_vertices.freeBlocks();
+    stats.largestVertexFreeBlock = m_vertices.largestFreeBlock();
+    unsigned int vertexFree = m_vertices.capacity() - m_vertices.used();
+    unsigned int indexFree = m_indices.capacity() - m_indices.used();
+    stats.vertexFragmentation = vertexFree == 0 ? 0.f : 1.f - m_vertices.largestFreeBlock() / (float) vertexFree;
+    stats.indexFragmentation = indexFree == 0 ? 0.f : 1.f - m_indices.largestFreeBlock() / (float) indexFree;
+    stats.grows = m_grows;
+    return stats;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "arenaallocator.h"
+#include "openglcontext.h"
+#include "glm_includes.h"
+#include <vector>
+
+// Vertices and indices a chunk's meshes take, at the high end of what
+// zones of every biome average, for sizing the arena ahead of time
+#define ARENA_VERTICES_PER_CHUNK 14000
+#define ARENA_INDICES_PER_CHUNK 21000
+// Chunks the arena has room for before anything reserves more: one zone.
+// It grows by half whenever an upload doesn't fit.
+#define ARENA_INITIAL_CHUNKS 16
+
+// The meshes to draw in one glMultiDrawElementsBaseVertex call. Kept
+// between frames so the arrays don't reallocate.
+struct ArenaDrawBatch {
+    // Index count of each mesh
+    std::vector<GLsizei> counts;
+    // Byte offset of each mesh's first index in the index buffer
+    std::vector<const void*> indexOffsets;
+    // Arena vertex each mesh's indices count from
+    std::vector<GLint> baseVertices;
+
+    void clear();
+    void add(const ArenaMesh &mesh);
+    int size() const;
+};
+
+// How full and how fragmented a ChunkArena is
+struct ChunkArenaStats {
+    // Meshes held
+    int meshes = 0;
+    // Vertex buffer capacity and use, in vertices
+    unsigned int vertexCapacity = 0;
+    unsigned int verticesUsed = 0;
+    // Index buffer capacity and use, in indices
+    unsigned int indexCapacity = 0;
+    unsigned int indicesUsed = 0;
+    // Free blocks in the vertex buffer, and the largest of them
+    int vertexFreeBlocks = 0;
+    unsigned int largestVertexFreeBlock = 0;
+    // 1 - largest free block / free space, for each buffer. 0 when all the
+    // free space is in one block, approaching 1 as it splinters.
+    float vertexFragmentation = 0.f;
+    float indexFragmentation = 0.f;
+    // Times the buffers had to grow
+    int grows = 0;
+};
+
+// One vertex buffer and one index buffer holding every chunk's opaque and
+// transparent meshes, so all of them can be drawn through one VAO with one
+// multi-draw call per pass. Vertices are interleaved position, normal and
+// UV vec4s with positions in world space, since a multi-draw can't change
+// a uniform between meshes. Indices are relative to the mesh's first vertex.
+class ChunkArena {
+private:
+    OpenGLContext *mp_context;
+    GLuint m_vertexBuffer;
+    GLuint m_indexBuffer;
+    GLuint m_vao;
+    bool m_created;
+
+    ArenaAllocator m_vertices;
+    ArenaAllocator m_indices;
+    int m_grows;
+
+    // Allocates the buffers and VAO on the GPU. Called on the first upload,
+    // since the arena is built before there is a GL context.
+    void create();
+    // Replaces buffer with a larger one holding the same data
+    void growBuffer(GLuint &buffer, GLsizeiptr oldBytes, GLsizeiptr newBytes);
+    // Grows either buffer that is smaller than the given capacity
+    void growTo(unsigned int vertices, unsigned int indices);
+    // Points the VAO's attributes and index buffer at the current buffers
+    void setUpVAO();
+
+public:
+    ChunkArena(OpenGLContext *context);
+
+    // Deallocate all GPU-side data
+    void destroy();
+    // Makes room for about this many chunks' meshes in total, so loading
+    // them doesn't grow the buffers piece by piece
+    void reserve(int chunks);
+    // Copies a mesh into the arena, replacing what mesh held before.
+    // The buffers grow if there is no room for it.
+    void upload(ArenaMesh &mesh, const std::vector<glm::vec4> &combined, const std::vector<GLuint> &idx);
+    // Overwrites the indices of a mesh in place with as many new ones
+    void uploadIndices(const ArenaMesh &mesh, const std::vector<GLuint> &idx);
+    // Frees the arena space mesh holds
+    void release(ArenaMesh &mesh);
+    // Binds the VAO every arena mesh is drawn with
+    void bindVAO();
+
+    ChunkArenaStats getStats() const;
+};
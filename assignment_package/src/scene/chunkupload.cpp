@@ -0,0 +1,75 @@
+// The parts of Chunk that put its meshes on the GPU. They live apart from
+// chunk.cpp so the headless tools can link the generation code without a
+// GL context or Qt's OpenGL modules; only the game and terrainbench build
+// this file.
+#include "chunk.h"
+#include "chunkarena.h"
+
+#include <algorithm>
+#include <type_traits>
+
+// Chunk builds its index vectors as unsigned ints, without GL's headers,
+// and hands them straight to the arena
+static_assert(std::is_same<GLuint, unsigned int>::value, "GLuint is not unsigned int");
+
+void Chunk::createVBOdata()
+{
+    std::vector<unsigned int> idx_o, idx_t;
+    std::vector<glm::vec4> combined_o, combined_t;
+
+    // fill vectors
+    getInterleavedVBOdata(idx_o, combined_o, idx_t, combined_t);
+    getSectionConnectivity(m_sectionConnectivity);
+    // not sorted, so there are no face centers to keep
+    std::vector<glm::vec3> centers_t;
+    bufferInterleavedVBOdata(idx_o, combined_o, idx_t, combined_t, centers_t);
+}
+
+void Chunk::sortTransparentFaces(glm::vec3 eye) {
+    if (m_faceCentersTra.empty() || mp_arena == nullptr) {
+        return;
+    }
+    std::vector<unsigned int> idx;
+    sortFacesBackToFront(idx, m_faceCentersTra, eye - glm::vec3(X, 0, Z));
+    mp_arena->uploadIndices(m_meshTra, idx);
+}
+
+void Chunk::bufferInterleavedVBOdata(std::vector<unsigned int>& idxOpq, std::vector<glm::vec4>& combinedOpq,
+                                     std::vector<unsigned int>& idxTra, std::vector<glm::vec4>& combinedTra,
+                                     std::vector<glm::vec3>& centersTra)
+{
+    m_countOpq = idxOpq.size();
+    m_countTra = idxTra.size();
+
+    // Every vertex is a position, a normal and a UV, so positions are every
+    // third vec4. Their heights give the box the frustum culling tests.
+    // Every mesh in the arena is drawn by the same multi-draw call, so the
+    // chunk's offset can't be a uniform; it is baked into the positions.
+    m_meshMinY = HEIGHT;
+    m_meshMaxY = 0;
+    for (auto *combined : {&combinedOpq, &combinedTra}) {
+        for (size_t i = 0; i < combined->size(); i += 3) {
+            glm::vec4 &pos = (*combined)[i];
+            int y = static_cast<int>(pos.y);
+            m_meshMinY = std::min(m_meshMinY, y);
+            m_meshMaxY = std::max(m_meshMaxY, y);
+            pos.x += X;
+            pos.z += Z;
+        }
+    }
+
+    mp_arena->upload(m_meshOpq, combinedOpq, idxOpq);
+    mp_arena->upload(m_meshTra, combinedTra, idxTra);
+    m_faceCentersTra.swap(centersTra);
+
+    isBuffered = true;
+}
+
+void Chunk::destroyVBOdata() {
+    if (mp_arena != nullptr) {
+        mp_arena->release(m_meshOpq);
+        mp_arena->release(m_meshTra);
+    }
+    m_faceCentersTra.clear();
+    m_countOpq = m_countTra = -1;
+}
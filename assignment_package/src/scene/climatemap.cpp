@@ -0,0 +1,52 @@
+#include "climatemap.h"
+
+ClimateMap::ClimateMap(int x, int z, int width)
+    : X(x), Z(z), WIDTH(width), m_columns(width * width)
+{
+    std::vector<float> heightBlend(WIDTH), humidityBlend(WIDTH), oceanWeight(WIDTH);
+    std::vector<int> terrainHeight(WIDTH);
+
+    // evaluate the noise a whole row of columns at a time
+    for (int dz = 0; dz < WIDTH; ++dz) {
+        int wz = Z + dz;
+        Chunk::getHeightHumidityBlendRow(X, wz, WIDTH, heightBlend.data(), humidityBlend.data());
+        Chunk::getOceanWeightRow(X, wz, WIDTH, oceanWeight.data());
+        Chunk::getTerrainHeightRow(X, wz, WIDTH, heightBlend.data(), humidityBlend.data(),
+                                   oceanWeight.data(), terrainHeight.data());
+
+        for (int dx = 0; dx < WIDTH; ++dx) {
+            ColumnClimate &column = m_columns[dx + WIDTH * dz];
+            column.heightBlend = heightBlend[dx];
+            column.humidityBlend = humidityBlend[dx];
+            column.oceanWeight = oceanWeight[dx];
+            column.terrainHeight = terrainHeight[dx];
+            column.biome = Chunk::getBiome(column.heightBlend, column.humidityBlend, column.oceanWeight);
+        }
+    }
+}
+
+bool ClimateMap::contains(int x, int z) const
+{
+    return x >= X && x < X + WIDTH && z >= Z && z < Z + WIDTH;
+}
+
+const ColumnClimate& ClimateMap::at(int x, int z) const
+{
+    return m_columns[(x - X) + WIDTH * (z - Z)];
+}
+
+int ClimateMap::getTerrainHeight(int x, int z) const
+{
+    if (contains(x, z)) {
+        return at(x, z).terrainHeight;
+    }
+    return Chunk::getTerrainHeight(x, z);
+}
+
+Biome ClimateMap::getBiome(int x, int z) const
+{
+    if (contains(x, z)) {
+        return at(x, z).biome;
+    }
+    return Chunk::getBiome(x, z);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "chunk.h"
+
+#include <vector>
+
+// The climate and terrain height of one x-z column of the world
+struct ColumnClimate {
+    float heightBlend;
+    float humidityBlend;
+    float oceanWeight;
+    int terrainHeight;
+    Biome biome;
+};
+
+// Caches the climate of every column in a square area of the world,
+// normally one 64 x 64 terrain generation zone. It is computed once by
+// the zone's BDWorker and then shared read-only by the zone's Chunks,
+// both for their terrain columns and for their structure placement.
+class ClimateMap
+{
+public:
+    // Computes the climate of the width x width columns whose
+    // lower-left corner is at (x, z)
+    ClimateMap(int x, int z, int width);
+
+    const int X, Z, WIDTH;
+
+    // Is this world-space column covered by the map?
+    bool contains(int x, int z) const;
+    // Assuming the map contains it, return the climate of this column
+    const ColumnClimate& at(int x, int z) const;
+
+    // These read from the map when it contains the column,
+    // and compute the value from scratch otherwise
+    int getTerrainHeight(int x, int z) const;
+    Biome getBiome(int x, int z) const;
+
+private:
+    std::vector<ColumnClimate> m_columns;
+};
@@ -0,0 +1,30 @@
+#include "frustum.h"
+
+Frustum::Frustum(const glm::mat4 &viewProj)
+    : m_planes()
+{
+    // Gribb-Hartmann: each clip-space bound -w <= x, y, z <= w is a
+    // plane formed from the matrix's last row plus or minus another row.
+    // glm matrices are column-major, so row i is (m[0][i], ..., m[3][i]).
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i) {
+        rows[i] = glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+    }
+    for (int i = 0; i < 3; ++i) {
+        m_planes[2 * i] = rows[3] + rows[i];
+        m_planes[2 * i + 1] = rows[3] - rows[i];
+    }
+}
+
+bool Frustum::intersects(glm::vec3 min, glm::vec3 max) const {
+    for (const glm::vec4 &plane : m_planes) {
+        // the corner of the box furthest along the plane's normal
+        glm::vec3 corner(plane.x >= 0 ? max.x : min.x,
+                         plane.y >= 0 ? max.y : min.y,
+                         plane.z >= 0 ? max.z : min.z);
+        if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "glm_includes.h"
+#include <array>
+
+// The six planes of a camera's view frustum in world space, extracted
+// from its view-projection matrix. Pure math with no GL state, so it can
+// be used and checked anywhere.
+class Frustum
+{
+public:
+    // Extracts the planes of the frustum that viewProj maps to clip space
+    Frustum(const glm::mat4 &viewProj);
+
+    // Does the axis-aligned box from min to max overlap the frustum?
+    // Conservative: a box near a corner of the frustum may pass
+    // even though it lies just outside.
+    bool intersects(glm::vec3 min, glm::vec3 max) const;
+
+private:
+    // Each plane is (normal, d), with the normal pointing into the frustum,
+    // so a point p is inside when dot(normal, p) + d >= 0 for every plane
+    std::array<glm::vec4, 6> m_planes;
+};
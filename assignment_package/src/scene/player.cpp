@@ -113,12 +113,20 @@ void Player::computePhysics(float dT, const Terrain &terrain) {
             glm::vec3 rayy = glm::vec3(0, moveRay.y, 0);
             glm::vec3 rayz = glm::vec3(0, 0, moveRay.z);
 
-            for (glm::vec3 offset : collisionVerts) {
-                glm::vec3 pos = offset + m_position;
+            // look up the blocks at every collision vert in one pass,
+            // treating verts in unloaded chunks as empty space
+            std::array<glm::ivec3, 12> vertCells;
+            std::array<BlockType, 12> vertBlocks;
+            for (size_t i = 0; i < collisionVerts.size(); ++i) {
+                vertCells[i] = glm::ivec3(collisionVerts[i] + m_position);
+            }
+            terrain.queryBlocksAt(vertCells.data(), vertCells.size(), vertBlocks.data(), EMPTY);
+
+            for (size_t i = 0; i < collisionVerts.size(); ++i) {
+                glm::vec3 pos = collisionVerts[i] + m_position;
 
-                // get block and associated physics at vert
-                BlockType block = terrain.getBlockAt(pos);
-                BlockPhysics phys = getBlockPhysics(block);
+                // get associated physics at vert
+                BlockPhysics phys = getBlockPhysics(vertBlocks[i]);
                 maxDrag = glm::max(maxDrag, phys.drag);
 
                 canClimb = canClimb || phys.canClimb;
@@ -189,7 +197,8 @@ bool Player::gridMarch(glm::vec3 rayOrigin, glm::vec3 rayDirection, const Terrai
             }
         }
         if(interfaceAxis == -1) {
-            throw std::out_of_range("interfaceAxis was -1 after the for loop in gridMarch!");
+            // no axis to step along, so there is nothing to hit
+            return false;
         }
         curr_t += min_t; // min_t is declared in slide 7 algorithm
         rayOrigin += rayDirection * min_t;
@@ -198,9 +207,10 @@ bool Player::gridMarch(glm::vec3 rayOrigin, glm::vec3 rayDirection, const Terrai
         offset[interfaceAxis] = glm::min(0.f, glm::sign(rayDirection[interfaceAxis]));
         if (!(std::isnan(rayOrigin.x) || std::isnan(rayOrigin.y) || std::isnan(rayOrigin.z))) {
             currCell = glm::ivec3(glm::floor(rayOrigin)) + offset;
-            // If currCell contains a solid block, return
-            BlockType cellType = terrain.getBlockAt(currCell.x, currCell.y, currCell.z);
-            if(getBlockPhysics(cellType).isSolid) {
+            // If currCell contains a solid block, return.
+            // Unloaded chunks count as solid so we never fall out of the world.
+            std::optional<BlockType> cellType = terrain.queryBlockAt(currCell.x, currCell.y, currCell.z);
+            if(!cellType.has_value() || getBlockPhysics(*cellType).isSolid) {
                 return true;
             }
         }
@@ -0,0 +1,126 @@
+#include "precipitation.h"
+#include <algorithm>
+#include <limits>
+
+// A stable pseudo-random value in [0, 1) for a column and drop, so a
+// drop lands in the same spot every time the instances are rebuilt
+static float dropJitter(int x, int z, int drop, int axis) {
+    unsigned int h = static_cast<unsigned int>(x) * 73856093u ^ static_cast<unsigned int>(z) * 19349663u
+                     ^ static_cast<unsigned int>(drop * 2 + axis) * 83492791u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    return (h & 0xffffu) / 65536.f;
+}
+
+Precipitation::Precipitation(OpenGLContext *context)
+    : InstancedDrawable(context), m_cameraBlock(std::numeric_limits<int>::min()),
+      m_framesSinceBuild(0), m_blocks(), m_offsets(), m_stats()
+{}
+
+void Precipitation::createVBOdata()
+{
+    // One drop: a sheet of the rain or snow texture 1 block wide and 4
+    // tall, the same scale the texture had on the old planes around the
+    // camera. Its bottom edge sits on the instance's position.
+    GLuint idx[6]{0, 1, 2, 0, 2, 3};
+    glm::vec4 vert_pos[4] {glm::vec4(-0.5f, 0.f, 0.f, 1.f),
+                           glm::vec4(0.5f, 0.f, 0.f, 1.f),
+                           glm::vec4(0.5f, 4.f, 0.f, 1.f),
+                           glm::vec4(-0.5f, 4.f, 0.f, 1.f)};
+
+    glm::vec2 vert_UV[4] {glm::vec2(1.f, 0.f),
+                          glm::vec2(0.f, 0.f),
+                          glm::vec2(0.f, 1.f),
+                          glm::vec2(1.f, 1.f)};
+
+    m_countTra = 6;
+
+    generateIdxTra();
+    mp_context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_bufIdxTra);
+    mp_context->glBufferData(GL_ELEMENT_ARRAY_BUFFER, 6 * sizeof(GLuint), idx, GL_STATIC_DRAW);
+
+    generatePosTra();
+    mp_context->glBindBuffer(GL_ARRAY_BUFFER, m_bufPosTra);
+    mp_context->glBufferData(GL_ARRAY_BUFFER, 4 * sizeof(glm::vec4), vert_pos, GL_STATIC_DRAW);
+    generateUVTra();
+    mp_context->glBindBuffer(GL_ARRAY_BUFFER, m_bufUVTra);
+    mp_context->glBufferData(GL_ARRAY_BUFFER, 4 * sizeof(glm::vec2), vert_UV, GL_STATIC_DRAW);
+}
+
+void Precipitation::createInstancedVBOdata(std::vector<glm::vec3> &offsets) {
+    m_numInstances = offsets.size();
+
+    if (!m_offsetGenerated) {
+        generateOffsetBuf();
+    }
+    mp_context->glBindBuffer(GL_ARRAY_BUFFER, m_bufPosOffset);
+    mp_context->glBufferData(GL_ARRAY_BUFFER, offsets.size() * sizeof(glm::vec3), offsets.data(), GL_DYNAMIC_DRAW);
+}
+
+void Precipitation::destroyVBOdata() {
+    Drawable::destroyVBOdata();
+    clearOffsetBuf();
+    m_numInstances = 0;
+}
+
+void Precipitation::update(const Terrain &terrain, glm::vec3 eye) {
+    glm::ivec3 cameraBlock(glm::floor(eye));
+    if (m_offsetGenerated && cameraBlock == m_cameraBlock
+            && ++m_framesSinceBuild < PRECIPITATION_REBUILD_FRAMES) {
+        return;
+    }
+    m_cameraBlock = cameraBlock;
+    m_framesSinceBuild = 0;
+
+    // Read every column from the lowest point a drop can reach to the top
+    // of the world, since a block anywhere above the camera can cover it
+    int bottom = glm::clamp(cameraBlock.y - PRECIPITATION_BELOW, 0, Chunk::HEIGHT);
+    int top = cameraBlock.y + PRECIPITATION_ABOVE;
+    glm::ivec3 min(cameraBlock.x - PRECIPITATION_RADIUS, bottom, cameraBlock.z - PRECIPITATION_RADIUS);
+    glm::ivec3 max(cameraBlock.x + PRECIPITATION_RADIUS + 1, Chunk::HEIGHT, cameraBlock.z + PRECIPITATION_RADIUS + 1);
+    glm::ivec3 size = max - min;
+    m_blocks.resize(size.x * size.y * size.z);
+    terrain.readRegion(min, max, m_blocks.data(), EMPTY);
+
+    m_stats.columns = size.x * size.z;
+    m_stats.covered = 0;
+    m_offsets.clear();
+    for (int z = 0; z < size.z; ++z) {
+        for (int x = 0; x < size.x; ++x) {
+            // the highest block in the column, if it is in the range read
+            int highest = bottom - 1;
+            for (int y = size.y - 1; y >= 0; --y) {
+                if (m_blocks[x + size.x * (y + size.y * z)] != EMPTY) {
+                    highest = bottom + y;
+                    break;
+                }
+            }
+            if (highest >= top) {
+                ++m_stats.covered;
+                continue;
+            }
+            float floorY = static_cast<float>(std::max(highest + 1, cameraBlock.y - PRECIPITATION_BELOW));
+            int wx = min.x + x, wz = min.z + z;
+            for (int drop = 0; drop < PRECIPITATION_DROPS_PER_COLUMN; ++drop) {
+                m_offsets.push_back(glm::vec3(wx + dropJitter(wx, wz, drop, 0), floorY,
+                                              wz + dropJitter(wx, wz, drop, 1)));
+            }
+        }
+    }
+    m_stats.drops = static_cast<int>(m_offsets.size());
+    createInstancedVBOdata(m_offsets);
+}
+
+void Precipitation::draw(ShaderProgram *shader, int textureSlot) {
+    m_stats.drawCalls = 0;
+    if (m_numInstances == 0) {
+        return;
+    }
+    shader->drawInstancedTra(*this, textureSlot);
+    m_stats.drawCalls = 1;
+}
+
+const PrecipitationStats& Precipitation::getStats() const {
+    return m_stats;
+}
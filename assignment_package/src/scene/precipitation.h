@@ -0,0 +1,70 @@
+#pragma once
+
+#include "drawable.h"
+#include "shaderprogram.h"
+#include "terrain.h"
+
+#include <vector>
+
+// Height above which precipitation falls as snow instead of rain
+#define SNOW_HEIGHT 190
+// Drops fall over the columns up to this many blocks from the camera's,
+// along x and z
+#define PRECIPITATION_RADIUS 16
+// Drops falling in each column at once
+#define PRECIPITATION_DROPS_PER_COLUMN 2
+// Drops fall from this many blocks above the camera down to the highest
+// block of their column, or this many blocks below the camera if that is
+// higher. Must match FALL_ABOVE in rain.vert.glsl and snow.vert.glsl.
+#define PRECIPITATION_ABOVE 20
+#define PRECIPITATION_BELOW 12
+// Frames between rebuilds while the camera stays in one block, so drops
+// follow blocks that are placed or broken
+#define PRECIPITATION_REBUILD_FRAMES 60
+
+// What the last rebuild and draw of a Precipitation did
+struct PrecipitationStats {
+    // Drops instanced
+    int drops = 0;
+    // Columns around the camera, and those of them skipped because a
+    // block above the drops' starting height covers them
+    int columns = 0;
+    int covered = 0;
+    // Draw calls issued for all the drops in the last frame
+    int drawCalls = 0;
+};
+
+// Rain or snow around the camera, drawn as one instanced quad per drop.
+// Each instance holds the x and z of its drop and the height it stops at,
+// read from the terrain, and the vertex shader moves it down from above
+// the camera over time, so the instances only change when the camera
+// moves into another block.
+class Precipitation : public InstancedDrawable
+{
+private:
+    // Camera block the drops were last built around
+    glm::ivec3 m_cameraBlock;
+    int m_framesSinceBuild;
+    // Scratch space for rebuilds, kept so they don't reallocate
+    std::vector<BlockType> m_blocks;
+    std::vector<glm::vec3> m_offsets;
+    PrecipitationStats m_stats;
+
+public:
+    Precipitation(OpenGLContext* context);
+    virtual ~Precipitation(){}
+    void createVBOdata() override;
+    // Replaces the drops with one instance per offset
+    void createInstancedVBOdata(std::vector<glm::vec3> &offsets) override;
+    // Frees the quad and the instance buffer
+    void destroyVBOdata() override;
+
+    // Rebuilds the drops around the camera at eye if it moved into another
+    // block or they are PRECIPITATION_REBUILD_FRAMES old. Columns covered
+    // by blocks above PRECIPITATION_ABOVE get no drops.
+    void update(const Terrain &terrain, glm::vec3 eye);
+    // Draws every drop with a single instanced draw call
+    void draw(ShaderProgram *shader, int textureSlot);
+
+    const PrecipitationStats& getStats() const;
+};
@@ -1,8 +1,13 @@
 #include "icespike.h"
 
+int IceSpike::height() const
+{
+    return glm::mix(4, 25, seed);
+}
+
 std::vector<std::pair<BlockType, glm::ivec3>> IceSpike::getStructureBlocks()
 {
-    int height = glm::mix(4, 25, seed);
+    int height = this->height();
 
     std::vector<std::pair<BlockType, glm::ivec3>> blocks;
 
@@ -28,3 +33,9 @@ std::vector<std::pair<BlockType, glm::ivec3>> IceSpike::getStructureBlocks()
 
     return blocks;
 }
+
+const StructureStencil& IceSpike::getStencil()
+{
+    static StencilCache stencils;
+    return stencils.get(height(), [this]() { return getStructureBlocks(); });
+}
@@ -8,4 +8,10 @@ public:
     using Structure::Structure;
 
     std::vector<std::pair<BlockType, glm::ivec3>> getStructureBlocks() override;
+    const StructureStencil& getStencil() override;
+
+private:
+    // Height of the inner spike above and below the root, from 4 to 25
+    // depending on the seed
+    int height() const;
 };
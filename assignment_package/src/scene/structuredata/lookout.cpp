@@ -2,9 +2,14 @@
 
 #define LOOKOUT_BLOCK COBBLESTONE
 
+int Lookout::height() const
+{
+    return glm::mix(5, 28, seed);
+}
+
 std::vector<std::pair<BlockType, glm::ivec3>> Lookout::getStructureBlocks()
 {
-    int height = glm::mix(5, 28, seed);
+    int height = this->height();
 
     std::vector<std::pair<BlockType, glm::ivec3>> blocks;
 
@@ -25,3 +30,9 @@ std::vector<std::pair<BlockType, glm::ivec3>> Lookout::getStructureBlocks()
 
     return blocks;
 }
+
+const StructureStencil& Lookout::getStencil()
+{
+    static StencilCache stencils;
+    return stencils.get(height(), [this]() { return getStructureBlocks(); });
+}
@@ -8,4 +8,9 @@ public:
     using Structure::Structure;
 
     std::vector<std::pair<BlockType, glm::ivec3>> getStructureBlocks() override;
+    const StructureStencil& getStencil() override;
+
+private:
+    // Height of the tower above the root, from 5 to 28 depending on the seed
+    int height() const;
 };
@@ -1,9 +1,13 @@
 #include "pyramid.h"
 
+int Pyramid::radius() const
+{
+    return glm::mix(15, 35, seed);
+}
+
 std::vector<std::pair<BlockType, glm::ivec3>> Pyramid::getStructureBlocks()
 {
-    // seed determines how big it is, from radius 15 to 35
-    int radius = glm::mix(15, 35, seed);
+    int radius = this->radius();
 
     std::vector<std::pair<BlockType, glm::ivec3>> blocks;
 
@@ -17,3 +21,9 @@ std::vector<std::pair<BlockType, glm::ivec3>> Pyramid::getStructureBlocks()
 
     return blocks;
 }
+
+const StructureStencil& Pyramid::getStencil()
+{
+    static StencilCache stencils;
+    return stencils.get(radius(), [this]() { return getStructureBlocks(); });
+}
@@ -8,4 +8,9 @@ public:
     using Structure::Structure;
 
     std::vector<std::pair<BlockType, glm::ivec3>> getStructureBlocks() override;
+    const StructureStencil& getStencil() override;
+
+private:
+    // Radius of its base, from 15 to 35 depending on the seed
+    int radius() const;
 };
@@ -0,0 +1,50 @@
+#include "stencil.h"
+
+#include <climits>
+
+static glm::ivec3 boundsMin(const std::vector<std::pair<BlockType, glm::ivec3>> &blocks) {
+    if (blocks.empty()) {
+        return glm::ivec3(0);
+    }
+    glm::ivec3 result(INT_MAX);
+    for (auto &block : blocks) {
+        result = glm::min(result, block.second);
+    }
+    return result;
+}
+
+static glm::ivec3 boundsMax(const std::vector<std::pair<BlockType, glm::ivec3>> &blocks) {
+    if (blocks.empty()) {
+        return glm::ivec3(0);
+    }
+    glm::ivec3 result(INT_MIN);
+    for (auto &block : blocks) {
+        result = glm::max(result, block.second + glm::ivec3(1));
+    }
+    return result;
+}
+
+StructureStencil::StructureStencil(const std::vector<std::pair<BlockType, glm::ivec3>> &blocks)
+    : min(boundsMin(blocks)), max(boundsMax(blocks)), m_voxels()
+{
+    glm::ivec3 size = max - min;
+    m_voxels.assign(size.x * size.y * size.z, EMPTY);
+    for (auto &block : blocks) {
+        glm::ivec3 p = block.second - min;
+        m_voxels[p.x + size.x * p.y + size.x * size.y * p.z] = block.first;
+    }
+}
+
+const BlockType* StructureStencil::row(int y, int z) const {
+    glm::ivec3 size = max - min;
+    return &m_voxels[size.x * (y - min.y) + size.x * size.y * (z - min.z)];
+}
+
+const StructureStencil& StencilCache::get(int size, const std::function<std::vector<std::pair<BlockType, glm::ivec3>>()> &blocks) {
+    QMutexLocker locker(&m_lock);
+    uPtr<StructureStencil> &stencil = m_stencils[size];
+    if (!stencil) {
+        stencil = mkU<StructureStencil>(blocks());
+    }
+    return *stencil;
+}
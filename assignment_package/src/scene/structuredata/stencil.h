@@ -0,0 +1,45 @@
+#pragma once
+
+#include "scene/chunk.h"
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <QMutex>
+
+// An immutable dense voxel template of one structure: its blocks laid out
+// inside their axis-aligned bounding box, relative to the structure's root.
+// EMPTY marks voxels the structure leaves untouched, so structures can't
+// place EMPTY blocks themselves.
+class StructureStencil
+{
+public:
+    // Later blocks overwrite earlier ones at the same position, just like
+    // writing the list into a chunk block by block
+    StructureStencil(const std::vector<std::pair<BlockType, glm::ivec3>> &blocks);
+
+    // bounding box relative to the root, max exclusive
+    const glm::ivec3 min, max;
+
+    // The voxels of the row at height y and depth z, starting from x = min.x.
+    // y and z are relative to the root and must lie inside the box.
+    const BlockType* row(int y, int z) const;
+
+private:
+    std::vector<BlockType> m_voxels;
+};
+
+// The stencils of one structure type, built on first use for each size and
+// shared by every chunk afterwards. Safe to use from several BDWorkers.
+// size must be all that the structure's blocks depend on, so each type keys
+// its stencils with the same seed-derived size accessor its
+// getStructureBlocks builds from.
+class StencilCache
+{
+public:
+    const StructureStencil& get(int size, const std::function<std::vector<std::pair<BlockType, glm::ivec3>>()> &blocks);
+
+private:
+    QMutex m_lock;
+    std::unordered_map<int, uPtr<StructureStencil>> m_stencils;
+};
@@ -2,15 +2,19 @@
 
 #include "vector"
 #include "scene/chunk.h"
+#include "stencil.h"
 
 class Structure
 {
 public:
     Structure(glm::ivec2 pos, float seed);
-    ~Structure();
+    virtual ~Structure();
 
     const glm::ivec2 pos;
     const float seed;
 
     virtual std::vector<std::pair<BlockType, glm::ivec3>> getStructureBlocks() = 0;
+    // The cached stencil of getStructureBlocks, shared by every structure
+    // of this type and size
+    virtual const StructureStencil& getStencil() = 0;
 };
@@ -30,3 +30,10 @@ std::vector<std::pair<BlockType, glm::ivec3>> Tree::getStructureBlocks()
 
     return blocks;
 }
+
+const StructureStencil& Tree::getStencil()
+{
+    static StencilCache stencils;
+    // every tree is the same
+    return stencils.get(0, [this]() { return getStructureBlocks(); });
+}
@@ -8,4 +8,5 @@ public:
     using Structure::Structure;
 
     std::vector<std::pair<BlockType, glm::ivec3>> getStructureBlocks() override;
+    const StructureStencil& getStencil() override;
 };
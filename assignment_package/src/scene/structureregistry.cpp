@@ -0,0 +1,152 @@
+#include "structureregistry.h"
+
+#include "climatemap.h"
+#include "structuredata/pyramid.h"
+#include "structuredata/tree.h"
+#include "structuredata/icespike.h"
+#include "structuredata/lookout.h"
+
+const std::array<StructureRegistry::Placement, StructureRegistry::KIND_COUNT> StructureRegistry::placements = {{
+    //  reach  cellSize  frequency  biome
+    {   35,    160.f,    0.4f,      DESERT      }, // PYRAMID
+    {   2,     10.f,     0.14f,     GRASS_LANDS }, // TREE
+    {   1,     13.f,     0.25f,     MOUNTAINS   }, // ICE_SPIKE
+    {   2,     16.f,     0.22f,     ARCHIPELAGO }, // LOOKOUT
+}};
+
+// packs a Voronoi cell into one map key
+static int64_t cellKey(int xCell, int zCell) {
+    return (int64_t(xCell) << 32) | uint32_t(zCell);
+}
+
+StructureRegistry::StructureRegistry() : m_cells(), m_cellsLock()
+{}
+
+// Voronoi cells of one kind whose structure could reach into the x-z
+// rectangle [minX, maxX) x [minZ, maxZ), as an inclusive range
+static void cellRange(float cellSize, int reach, int minX, int minZ, int maxX, int maxZ,
+                      glm::ivec2 &startCell, glm::ivec2 &endCell) {
+    startCell = glm::ivec2(glm::floor((minX - reach) * 1.f / cellSize),
+                           glm::floor((minZ - reach) * 1.f / cellSize));
+    endCell = glm::ivec2(glm::floor((maxX - 1 + reach) * 1.f / cellSize),
+                         glm::floor((maxZ - 1 + reach) * 1.f / cellSize));
+}
+
+std::vector<sPtr<const PlacedStructure>> StructureRegistry::query(int minX, int minZ, int maxX, int maxZ,
+                                                                  const ClimateMap &climate)
+{
+    // every cell the rectangle needs, in placement order
+    struct Slot {
+        Kind kind;
+        int xCell, zCell;
+        bool resolved;
+        sPtr<const PlacedStructure> placed;
+    };
+    std::vector<Slot> needed;
+    for (int kind = 0; kind < KIND_COUNT; ++kind) {
+        const Placement &p = placements[kind];
+        glm::ivec2 startCell, endCell;
+        cellRange(p.cellSize, p.reach, minX, minZ, maxX, maxZ, startCell, endCell);
+        for (int xCell = startCell.x; xCell <= endCell.x; ++xCell) {
+            for (int zCell = startCell.y; zCell <= endCell.y; ++zCell) {
+                needed.push_back({Kind(kind), xCell, zCell, false, nullptr});
+            }
+        }
+    }
+
+    bool missing = false;
+    m_cellsLock.lock();
+    for (Slot &slot : needed) {
+        auto it = m_cells[slot.kind].find(cellKey(slot.xCell, slot.zCell));
+        if (it != m_cells[slot.kind].end()) {
+            slot.resolved = true;
+            slot.placed = it->second;
+        } else {
+            missing = true;
+        }
+    }
+    m_cellsLock.unlock();
+
+    if (missing) {
+        for (Slot &slot : needed) {
+            if (!slot.resolved) {
+                slot.placed = resolve(slot.kind, slot.xCell, slot.zCell, climate);
+            }
+        }
+
+        // another BDWorker may have resolved the same cells meanwhile;
+        // keep whichever got there first so every chunk shares one copy
+        m_cellsLock.lock();
+        for (Slot &slot : needed) {
+            if (!slot.resolved) {
+                slot.placed = m_cells[slot.kind].emplace(cellKey(slot.xCell, slot.zCell), slot.placed).first->second;
+            }
+        }
+        m_cellsLock.unlock();
+    }
+
+    std::vector<sPtr<const PlacedStructure>> result;
+    for (Slot &slot : needed) {
+        const PlacedStructure *placed = slot.placed.get();
+        if (placed && placed->max.x > minX && placed->min.x < maxX
+                && placed->max.z > minZ && placed->min.z < maxZ) {
+            result.push_back(std::move(slot.placed));
+        }
+    }
+    return result;
+}
+
+void StructureRegistry::evictOutside(int minX, int minZ, int maxX, int maxZ)
+{
+    QMutexLocker locker(&m_cellsLock);
+    for (int kind = 0; kind < KIND_COUNT; ++kind) {
+        const Placement &p = placements[kind];
+        glm::ivec2 startCell, endCell;
+        cellRange(p.cellSize, p.reach, minX, minZ, maxX, maxZ, startCell, endCell);
+
+        auto &cells = m_cells[kind];
+        for (auto it = cells.begin(); it != cells.end();) {
+            int xCell = int(it->first >> 32);
+            int zCell = int32_t(uint32_t(it->first));
+            if (xCell < startCell.x || xCell > endCell.x || zCell < startCell.y || zCell > endCell.y) {
+                it = cells.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+sPtr<const PlacedStructure> StructureRegistry::resolve(Kind kind, int xCell, int zCell, const ClimateMap &climate)
+{
+    const Placement &p = placements[kind];
+    glm::ivec2 pos;
+    float seed;
+    if (!Chunk::getVoronoiPoint(xCell, zCell, p.cellSize, p.frequency, pos, seed)
+            || climate.getBiome(pos.x, pos.y) != p.biome) {
+        return nullptr;
+    }
+
+    sPtr<PlacedStructure> placed = mkS<PlacedStructure>();
+    switch (kind) {
+    case PYRAMID:
+        placed->structure = mkU<Pyramid>(pos, seed);
+        break;
+    case TREE:
+        placed->structure = mkU<Tree>(pos, seed);
+        break;
+    case ICE_SPIKE:
+        placed->structure = mkU<IceSpike>(pos, seed);
+        break;
+    case LOOKOUT:
+    default:
+        placed->structure = mkU<Lookout>(pos, seed);
+        break;
+    }
+
+    placed->stencil = &placed->structure->getStencil();
+    placed->root = glm::ivec3(pos.x, climate.getTerrainHeight(pos.x, pos.y), pos.y);
+    placed->min = placed->root + placed->stencil->min;
+    placed->max = placed->root + placed->stencil->max;
+    return placed;
+}
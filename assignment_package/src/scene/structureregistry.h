@@ -0,0 +1,69 @@
+#pragma once
+
+#include "smartpointerhelp.h"
+#include "glm_includes.h"
+#include "chunk.h"
+#include "structuredata/structure.h"
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+#include <QMutex>
+
+class ClimateMap;
+
+// A structure whose placement has been fully resolved
+struct PlacedStructure {
+    uPtr<Structure> structure;
+    const StructureStencil *stencil;
+    // world position of the structure's root block
+    glm::ivec3 root;
+    // world-space bounding box of its blocks, max exclusive
+    glm::ivec3 min, max;
+};
+
+// Resolves every structure of the world once while it is near the player,
+// no matter how many chunks it touches: its Voronoi cell, biome check, seed,
+// root height and bounding box. Shared by all BDWorkers of a Terrain.
+// Resolving a cell always gives the same structure, so cells can be
+// forgotten once the player moves away and resolved again if needed.
+class StructureRegistry
+{
+public:
+    StructureRegistry();
+
+    // All structures whose bounding box overlaps the x-z rectangle
+    // [minX, maxX) x [minZ, maxZ), in the order they must be placed.
+    // The climate map is only used to speed up resolving new structures.
+    // New cells are resolved without holding the lock, so BDWorkers don't
+    // wait on each other; if two resolve the same cell the first one kept wins.
+    std::vector<sPtr<const PlacedStructure>> query(int minX, int minZ, int maxX, int maxZ,
+                                                   const ClimateMap &climate);
+
+    // Forgets every cell whose structure couldn't reach into the x-z
+    // rectangle [minX, maxX) x [minZ, maxZ). Structures already returned
+    // by query stay alive until their callers drop them.
+    void evictOutside(int minX, int minZ, int maxX, int maxZ);
+
+private:
+    enum Kind {
+        PYRAMID, TREE, ICE_SPIKE, LOOKOUT, KIND_COUNT
+    };
+
+    // How one kind of structure is scattered over the world
+    struct Placement {
+        // furthest any block reaches from the root in x or z
+        int reach;
+        float cellSize;
+        float frequency;
+        Biome biome;
+    };
+    static const std::array<Placement, KIND_COUNT> placements;
+
+    // Builds the structure of a Voronoi cell, or returns nullptr if it has none
+    static sPtr<const PlacedStructure> resolve(Kind kind, int xCell, int zCell, const ClimateMap &climate);
+
+    // resolved cells of each kind, keyed by cell, nullptr for empty cells
+    std::array<std::unordered_map<int64_t, sPtr<const PlacedStructure>>, KIND_COUNT> m_cells;
+    QMutex m_cellsLock;
+};
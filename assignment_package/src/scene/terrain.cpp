@@ -1,17 +1,30 @@
 #include "terrain.h"
 #include "workers.h"
 #include <stdexcept>
+#include <algorithm>
+#include <limits>
 #include <QThreadPool>
+#include <cstdio>
 
 Terrain::Terrain(OpenGLContext *context)
-    : m_chunks(), m_generatedTerrain(), mp_context(context), m_newChunkTimer(0.499f)
-{}
+    : m_chunks(), m_generatedTerrain(), m_chunkGrid(), m_gridOrigin(0),
+      mp_context(context), m_newChunkTimer(0.499f),
+      m_createRadius(TERRAIN_CREATE_RADIUS), m_bufferedRadius(TERRAIN_CREATE_RADIUS), m_uploadMs(0.f),
+      m_drawStats(), m_drawEntries(), m_drawList(), m_drawArea(0, -1, 0, -1), m_chunkArena(context), m_opaqueBatch(), m_transparentBatch(), m_transparentOrder(),
+      m_sortTransparentFaces(true), m_sortEye(0.f), m_sortSection(std::numeric_limits<int>::min()),
+      m_sectionReached(), m_chunkReached(), m_sectionQueue(), m_spawnLoading(false), m_spawnLoadTimer(), mp_spawnChunk(nullptr), m_spawnChunkGenerated(false), m_spawnNeighborhood(),
+      m_spawnAreaChunks(), m_spawnChunksGenerating(0), m_spawnChunksMeshing()
+{
+    // The player spawns in the zone at (0, 0)
+    recenterChunkGrid(glm::ivec2(0, 0));
+}
 
 Terrain::~Terrain() {
     for (auto& chunkPair : m_chunks) {
         // do we need this?
         chunkPair.second->destroyVBOdata();
     }
+    m_chunkArena.destroy();
 }
 
 // Combine two 32-bit ints into one 64-bit int
@@ -46,22 +59,20 @@ glm::ivec2 toCoords(int64_t k) {
     return glm::ivec2(x, z);
 }
 
+// Integer division that rounds towards negative infinity,
+// so -1 / 16 maps to chunk -1 rather than chunk 0
+static int floorDiv(int a, int b) {
+    int q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
 // Surround calls to this with try-catch if you don't know whether
 // the coordinates at x, y, z have a corresponding Chunk
 BlockType Terrain::getBlockAt(int x, int y, int z) const
 {
-    if(hasChunkAt(x, z)) {
-        // Just disallow action below or above min/max height,
-        // but don't crash the game over it.
-        if(y < 0 || y >= Chunk::HEIGHT) {
-            return EMPTY;
-        }
-        const uPtr<Chunk> &c = getChunkAt(x, z);
-        glm::vec2 chunkOrigin = glm::vec2(floor(x / (float) Chunk::WIDTH) * Chunk::WIDTH,
-                                          floor(z / (float) Chunk::WIDTH) * Chunk::WIDTH);
-        return c->getBlockAt(static_cast<unsigned int>(x - chunkOrigin.x),
-                             static_cast<unsigned int>(y),
-                             static_cast<unsigned int>(z - chunkOrigin.y));
+    std::optional<BlockType> block = queryBlockAt(x, y, z);
+    if(block.has_value()) {
+        return *block;
     }
     else {
         throw std::out_of_range("Coordinates " + std::to_string(x) +
@@ -74,40 +85,87 @@ BlockType Terrain::getBlockAt(glm::vec3 p) const {
     return getBlockAt(p.x, p.y, p.z);
 }
 
+std::optional<BlockType> Terrain::queryBlockAt(int x, int y, int z) const
+{
+    const Chunk *c = findGeneratedChunkAt(x, z);
+    if(c == nullptr) {
+        return std::nullopt;
+    }
+    // Just disallow action below or above min/max height,
+    // but don't crash the game over it.
+    if(y < 0 || y >= Chunk::HEIGHT) {
+        return EMPTY;
+    }
+    return c->getBlockAt(x - c->X, y, z - c->Z);
+}
+
+std::optional<BlockType> Terrain::queryBlockAt(glm::vec3 p) const {
+    return queryBlockAt(p.x, p.y, p.z);
+}
+
+void Terrain::queryBlocksAt(const glm::ivec3 *positions, size_t count,
+                            BlockType *out, BlockType missing) const
+{
+    const Chunk *c = nullptr;
+    for (size_t i = 0; i < count; ++i) {
+        const glm::ivec3 &p = positions[i];
+        // Only look the chunk up again when we leave the previous one
+        if (c == nullptr || p.x < c->X || p.x >= c->X + Chunk::WIDTH
+                || p.z < c->Z || p.z >= c->Z + Chunk::WIDTH) {
+            c = findGeneratedChunkAt(p.x, p.z);
+        }
+        if (c == nullptr) {
+            out[i] = missing;
+        } else if (p.y < 0 || p.y >= Chunk::HEIGHT) {
+            out[i] = EMPTY;
+        } else {
+            out[i] = c->getBlockAt(p.x - c->X, p.y, p.z - c->Z);
+        }
+    }
+}
+
 bool Terrain::hasChunkAt(int x, int z) const {
-    // Map x and z to their nearest Chunk corner
-    // By flooring x and z, then multiplying by 16,
-    // we clamp (x, z) to its nearest Chunk-space corner,
-    // then scale back to a world-space location.
-    // Note that floor() lets us handle negative numbers
-    // correctly, as floor(-1 / 16.f) gives us -1, as
-    // opposed to (int)(-1 / 16.f) giving us 0 (incorrect!).
-    int xFloor = static_cast<int>(glm::floor(x / (float) Chunk::WIDTH));
-    int zFloor = static_cast<int>(glm::floor(z / (float) Chunk::WIDTH));
-    return m_chunks.find(toKey(Chunk::WIDTH * xFloor, Chunk::WIDTH * zFloor)) != m_chunks.end();
+    return findChunkAt(x, z) != nullptr;
+}
+
+Chunk* Terrain::findChunkAt(int x, int z) const {
+    // Map x and z to the chunk-space coords of the Chunk that contains them.
+    // floorDiv lets us handle negative numbers correctly.
+    int cx = floorDiv(x, Chunk::WIDTH);
+    int cz = floorDiv(z, Chunk::WIDTH);
+    // Every Chunk inside the grid window is stored in the grid,
+    // so an empty cell means there is no Chunk there at all.
+    if (inChunkGrid(cx, cz)) {
+        return m_chunkGrid[chunkGridIndex(cx, cz)];
+    }
+    auto it = m_chunks.find(toKey(Chunk::WIDTH * cx, Chunk::WIDTH * cz));
+    return it == m_chunks.end() ? nullptr : it->second.get();
+}
+
+Chunk* Terrain::findGeneratedChunkAt(int x, int z) const {
+    Chunk *c = findChunkAt(x, z);
+    return c != nullptr && c->isGenerated ? c : nullptr;
 }
 
 uPtr<Chunk>& Terrain::getChunkAt(int x, int z) {
-    int xFloor = static_cast<int>(glm::floor(x / (float) Chunk::WIDTH));
-    int zFloor = static_cast<int>(glm::floor(z / (float) Chunk::WIDTH));
+    int xFloor = floorDiv(x, Chunk::WIDTH);
+    int zFloor = floorDiv(z, Chunk::WIDTH);
     return m_chunks[toKey(Chunk::WIDTH * xFloor, Chunk::WIDTH * zFloor)];
 }
 
 const uPtr<Chunk>& Terrain::getChunkAt(int x, int z) const {
-    int xFloor = static_cast<int>(glm::floor(x / (float) Chunk::WIDTH));
-    int zFloor = static_cast<int>(glm::floor(z / (float) Chunk::WIDTH));
+    int xFloor = floorDiv(x, Chunk::WIDTH);
+    int zFloor = floorDiv(z, Chunk::WIDTH);
     return m_chunks.at(toKey(Chunk::WIDTH * xFloor, Chunk::WIDTH * zFloor));
 }
 
 void Terrain::setBlockAt(int x, int y, int z, BlockType t)
 {
-    if(hasChunkAt(x, z)) {
-        uPtr<Chunk> &c = getChunkAt(x, z);
-        glm::vec2 chunkOrigin = glm::vec2(floor(x / (float) Chunk::WIDTH) * Chunk::WIDTH,
-                                          floor(z / (float) Chunk::WIDTH) * Chunk::WIDTH);
-        c->setBlockAt(static_cast<unsigned int>(x - chunkOrigin.x),
+    Chunk *c = findGeneratedChunkAt(x, z);
+    if(c != nullptr) {
+        c->setBlockAt(static_cast<unsigned int>(x - c->X),
                       static_cast<unsigned int>(y),
-                      static_cast<unsigned int>(z - chunkOrigin.y),
+                      static_cast<unsigned int>(z - c->Z),
                       t);
     }
     else {
@@ -117,6 +175,255 @@ void Terrain::setBlockAt(int x, int y, int z, BlockType t)
     }
 }
 
+bool Terrain::inChunkGrid(int cx, int cz) const {
+    return cx >= m_gridOrigin.x && cx < m_gridOrigin.x + TERRAIN_GRID_WIDTH &&
+           cz >= m_gridOrigin.y && cz < m_gridOrigin.y + TERRAIN_GRID_WIDTH;
+}
+
+int Terrain::chunkGridIndex(int cx, int cz) const {
+    int gx = cx % TERRAIN_GRID_WIDTH;
+    int gz = cz % TERRAIN_GRID_WIDTH;
+    if (gx < 0) gx += TERRAIN_GRID_WIDTH;
+    if (gz < 0) gz += TERRAIN_GRID_WIDTH;
+    return gx + gz * TERRAIN_GRID_WIDTH;
+}
+
+void Terrain::recenterChunkGrid(glm::ivec2 zone) {
+    int chunksPerZone = 64 / Chunk::WIDTH;
+    m_gridOrigin = glm::ivec2(zone.x / Chunk::WIDTH, zone.y / Chunk::WIDTH)
+                   - glm::ivec2(TERRAIN_MAX_CREATE_RADIUS * chunksPerZone);
+
+    // Cells whose Chunk is still inside the new window keep it, since the
+    // grid is toroidal. Only the cells that wrapped around need a lookup.
+    for (int cx = m_gridOrigin.x; cx < m_gridOrigin.x + TERRAIN_GRID_WIDTH; ++cx) {
+        for (int cz = m_gridOrigin.y; cz < m_gridOrigin.y + TERRAIN_GRID_WIDTH; ++cz) {
+            Chunk *&cell = m_chunkGrid[chunkGridIndex(cx, cz)];
+            if (cell != nullptr && cell->X == cx * Chunk::WIDTH && cell->Z == cz * Chunk::WIDTH) {
+                continue;
+            }
+            auto it = m_chunks.find(toKey(cx * Chunk::WIDTH, cz * Chunk::WIDTH));
+            cell = it == m_chunks.end() ? nullptr : it->second.get();
+        }
+    }
+}
+
+template <typename F>
+void Terrain::forEachRegionRun(glm::ivec3 min, glm::ivec3 max, F &&f) const
+{
+    if (min.x >= max.x || min.y >= max.y || min.z >= max.z) {
+        return;
+    }
+    for (int cx = floorDiv(min.x, Chunk::WIDTH); cx <= floorDiv(max.x - 1, Chunk::WIDTH); ++cx) {
+        for (int cz = floorDiv(min.z, Chunk::WIDTH); cz <= floorDiv(max.z - 1, Chunk::WIDTH); ++cz) {
+            Chunk *c = findGeneratedChunkAt(cx * Chunk::WIDTH, cz * Chunk::WIDTH);
+            if (c == nullptr) {
+                continue;
+            }
+            // clip the region to this chunk
+            int x0 = glm::max(min.x, c->X), x1 = glm::min(max.x, c->X + Chunk::WIDTH);
+            int z0 = glm::max(min.z, c->Z), z1 = glm::min(max.z, c->Z + Chunk::WIDTH);
+            for (int z = z0; z < z1; ++z) {
+                for (int y = min.y; y < max.y; ++y) {
+                    BlockType *run = nullptr;
+                    if (y >= 0 && y < Chunk::HEIGHT) {
+                        run = &c->m_blocks[(x0 - c->X) + Chunk::WIDTH * y + Chunk::WIDTH * Chunk::HEIGHT * (z - c->Z)];
+                    }
+                    f(c, run, x1 - x0, glm::ivec3(x0, y, z));
+                }
+            }
+        }
+    }
+}
+
+void Terrain::readRegion(glm::ivec3 min, glm::ivec3 max, BlockType *out, BlockType missing) const
+{
+    glm::ivec3 size = max - min;
+    if (size.x <= 0 || size.y <= 0 || size.z <= 0) {
+        return;
+    }
+    std::fill_n(out, size.x * size.y * size.z, missing);
+    forEachRegionRun(min, max, [&](Chunk*, BlockType *run, int length, glm::ivec3 start) {
+        glm::ivec3 d = start - min;
+        BlockType *dst = out + d.x + size.x * (d.y + size.y * d.z);
+        if (run == nullptr) {
+            std::fill_n(dst, length, EMPTY);
+        } else {
+            std::copy_n(run, length, dst);
+        }
+    });
+}
+
+void Terrain::writeRegion(glm::ivec3 min, glm::ivec3 max, const BlockType *data, bool remesh)
+{
+    glm::ivec3 size = max - min;
+    std::unordered_set<Chunk*> touched;
+    Chunk *locked = nullptr;
+    forEachRegionRun(min, max, [&](Chunk *c, BlockType *run, int length, glm::ivec3 start) {
+        if (run == nullptr) return;
+        holdChunkLock(locked, c);
+        glm::ivec3 d = start - min;
+        std::copy_n(data + d.x + size.x * (d.y + size.y * d.z), length, run);
+        markDirty(touched, c, start.x - c->X, start.x - c->X + length - 1, start.z - c->Z, start.z - c->Z);
+    });
+    holdChunkLock(locked, nullptr);
+    if (remesh) {
+        remeshChunks(touched);
+    }
+}
+
+void Terrain::fillRegion(glm::ivec3 min, glm::ivec3 max, BlockType t, bool remesh)
+{
+    std::unordered_set<Chunk*> touched;
+    Chunk *locked = nullptr;
+    forEachRegionRun(min, max, [&](Chunk *c, BlockType *run, int length, glm::ivec3 start) {
+        if (run == nullptr) return;
+        holdChunkLock(locked, c);
+        std::fill_n(run, length, t);
+        markDirty(touched, c, start.x - c->X, start.x - c->X + length - 1, start.z - c->Z, start.z - c->Z);
+    });
+    holdChunkLock(locked, nullptr);
+    if (remesh) {
+        remeshChunks(touched);
+    }
+}
+
+void Terrain::replaceRegion(glm::ivec3 min, glm::ivec3 max, BlockType from, BlockType to, bool remesh)
+{
+    std::unordered_set<Chunk*> touched;
+    Chunk *locked = nullptr;
+    forEachRegionRun(min, max, [&](Chunk *c, BlockType *run, int length, glm::ivec3 start) {
+        if (run == nullptr) return;
+        holdChunkLock(locked, c);
+        BlockType *end = run + length;
+        if (std::find(run, end, from) == end) return;
+        std::replace(run, end, from, to);
+        markDirty(touched, c, start.x - c->X, start.x - c->X + length - 1, start.z - c->Z, start.z - c->Z);
+    });
+    holdChunkLock(locked, nullptr);
+    if (remesh) {
+        remeshChunks(touched);
+    }
+}
+
+void Terrain::copyRegion(glm::ivec3 srcMin, glm::ivec3 srcMax, glm::ivec3 dstMin, bool remesh)
+{
+    glm::ivec3 size = srcMax - srcMin;
+    if (size.x <= 0 || size.y <= 0 || size.z <= 0) {
+        return;
+    }
+    // Go through a buffer so overlapping regions don't read their own writes.
+    // Blocks from missing chunks become EMPTY.
+    std::vector<BlockType> buffer(size.x * size.y * size.z);
+    readRegion(srcMin, srcMax, buffer.data(), EMPTY);
+    writeRegion(dstMin, dstMin + size, buffer.data(), remesh);
+}
+
+void Terrain::markDirty(std::unordered_set<Chunk*> &dirty, Chunk *c,
+                        int minX, int maxX, int minZ, int maxZ)
+{
+    dirty.insert(c);
+    // Faces along a chunk border belong to the neighbor's mesh too
+    Chunk *n = nullptr;
+    if (minX == 0 && (n = c->getNeighbor(XNEG))) dirty.insert(n);
+    if (maxX == Chunk::WIDTH - 1 && (n = c->getNeighbor(XPOS))) dirty.insert(n);
+    if (minZ == 0 && (n = c->getNeighbor(ZNEG))) dirty.insert(n);
+    if (maxZ == Chunk::WIDTH - 1 && (n = c->getNeighbor(ZPOS))) dirty.insert(n);
+}
+
+size_t Terrain::remeshChunks(const std::unordered_set<Chunk*> &chunks)
+{
+    // Chunks that aren't buffered get meshed when they come into view
+    size_t count = 0;
+    for (Chunk *c : chunks) {
+        if (c->isBuffered) {
+            createVBOWorker(c);
+            ++count;
+        }
+    }
+    return count;
+}
+
+void Terrain::holdChunkLock(Chunk *&held, Chunk *c)
+{
+    if (held == c) {
+        return;
+    }
+    if (held != nullptr) {
+        held->chunkLock.unlock();
+    }
+    held = c;
+    if (held != nullptr) {
+        held->chunkLock.lock();
+    }
+}
+
+size_t Terrain::commitEdits(BlockEditBatch &batch)
+{
+    std::unordered_set<Chunk*> dirty;
+    Chunk *c = nullptr;
+    Chunk *locked = nullptr;
+    for (auto &edit : batch.m_edits) {
+        if (edit.max - edit.min != glm::ivec3(1)) {
+            forEachRegionRun(edit.min, edit.max, [&](Chunk *rc, BlockType *run, int length, glm::ivec3 start) {
+                if (run == nullptr) return;
+                holdChunkLock(locked, rc);
+                std::fill_n(run, length, edit.type);
+                markDirty(dirty, rc, start.x - rc->X, start.x - rc->X + length - 1, start.z - rc->Z, start.z - rc->Z);
+            });
+            continue;
+        }
+        const glm::ivec3 &p = edit.min;
+        if (p.y < 0 || p.y >= Chunk::HEIGHT) {
+            continue;
+        }
+        // Edits tend to be clustered, so reuse the last chunk when we can
+        if (c == nullptr || p.x < c->X || p.x >= c->X + Chunk::WIDTH
+                || p.z < c->Z || p.z >= c->Z + Chunk::WIDTH) {
+            c = findGeneratedChunkAt(p.x, p.z);
+            if (c == nullptr) {
+                continue;
+            }
+        }
+        holdChunkLock(locked, c);
+        int lx = p.x - c->X, lz = p.z - c->Z;
+        c->setBlockAt(static_cast<unsigned int>(lx), static_cast<unsigned int>(p.y),
+                      static_cast<unsigned int>(lz), edit.type);
+        markDirty(dirty, c, lx, lx, lz, lz);
+    }
+    holdChunkLock(locked, nullptr);
+    batch.clear();
+    return remeshChunks(dirty);
+}
+
+void BlockEditBatch::setBlockAt(int x, int y, int z, BlockType t)
+{
+    glm::ivec3 p(x, y, z);
+    m_edits.push_back({p, p + 1, t});
+}
+
+void BlockEditBatch::fillRegion(glm::ivec3 min, glm::ivec3 max, BlockType t)
+{
+    if (min.x >= max.x || min.y >= max.y || min.z >= max.z) {
+        return;
+    }
+    m_edits.push_back({min, max, t});
+}
+
+bool BlockEditBatch::empty() const
+{
+    return m_edits.empty();
+}
+
+size_t BlockEditBatch::size() const
+{
+    return m_edits.size();
+}
+
+void BlockEditBatch::clear()
+{
+    m_edits.clear();
+}
+
 void Terrain::initializeNearbyChunks(int x, int z, int chunkDistance, bool init)
 {
     int xFloor = static_cast<int>(glm::floor(x / (float) Chunk::WIDTH));
@@ -134,6 +441,8 @@ void Terrain::initializeNearbyChunks(int x, int z, int chunkDistance, bool init)
             {
                 Chunk* newChunk = instantiateChunkAt((xFloor + chunkOffsetX) * Chunk::WIDTH,
                                                      (zFloor + chunkOffsetZ) * Chunk::WIDTH, init);
+                // left empty without init, and nothing else will fill it
+                newChunk->isGenerated = true;
 
                 chunksToUpdate.insert(newChunk);
                 auto neighbors = newChunk->getNeighbors();
@@ -146,6 +455,7 @@ void Terrain::initializeNearbyChunks(int x, int z, int chunkDistance, bool init)
 
     for (auto* chunk : chunksToUpdate) {
         chunk->createVBOdata();
+        updateDrawEntry(chunk);
     }
 }
 
@@ -154,17 +464,25 @@ void Terrain::createAllChunkVBOdata()
     for (auto& chunkPair : m_chunks)
     {
         chunkPair.second->createVBOdata();
+        updateDrawEntry(chunkPair.second.get());
     }
 }
 
 Chunk* Terrain::instantiateChunkAt(int x, int z, bool init) {
     uPtr<Chunk> chunk;
-    chunk = mkU<Chunk>(mp_context, x, z);
+    chunk = mkU<Chunk>(x, z, &m_chunkArena);
     if (init) {
         chunk->generateTerrain();
     }
+    chunk->isGenerated = init;
     Chunk *cPtr = chunk.get();
     m_chunks[toKey(x, z)] = move(chunk);
+    // Keep the chunk grid in sync with the map
+    int cx = floorDiv(x, Chunk::WIDTH);
+    int cz = floorDiv(z, Chunk::WIDTH);
+    if (inChunkGrid(cx, cz)) {
+        m_chunkGrid[chunkGridIndex(cx, cz)] = cPtr;
+    }
     // Set the neighbor pointers of itself and its neighbors
     if(hasChunkAt(x, z + Chunk::WIDTH)) {
         auto &chunkNorth = m_chunks[toKey(x, z + Chunk::WIDTH)];
@@ -185,49 +503,215 @@ Chunk* Terrain::instantiateChunkAt(int x, int z, bool init) {
     return cPtr;
 }
 
-void Terrain::draw(int minX, int maxX, int minZ, int maxZ, ShaderProgram *shaderProgram) {
-    std::list<Chunk*> chunks;
+void Terrain::updateDrawEntry(Chunk* chunk) {
+    if (chunk->m_meshMinY > chunk->m_meshMaxY) {
+        // nothing to draw
+        removeDrawEntry(chunk);
+        return;
+    }
+    if (chunk->m_drawEntry < 0) {
+        chunk->m_drawEntry = static_cast<int>(m_drawEntries.size());
+        m_drawEntries.push_back(ChunkDrawEntry());
+    }
+    int cx = floorDiv(chunk->X, Chunk::WIDTH), cz = floorDiv(chunk->Z, Chunk::WIDTH);
+    ChunkDrawEntry &entry = m_drawEntries[chunk->m_drawEntry];
+    entry.chunk = chunk;
+    entry.gridCell = chunkGridIndex(cx, cz);
+    entry.boxMin = glm::vec3(chunk->X, chunk->m_meshMinY, chunk->Z);
+    entry.boxMax = glm::vec3(chunk->X + Chunk::WIDTH, chunk->m_meshMaxY, chunk->Z + Chunk::WIDTH);
+    entry.inRange = cx >= m_drawArea.x && cx <= m_drawArea.y && cz >= m_drawArea.z && cz <= m_drawArea.w;
+}
+
+void Terrain::removeDrawEntry(Chunk* chunk) {
+    if (chunk->m_drawEntry < 0) {
+        return;
+    }
+    // move the last entry into the hole
+    ChunkDrawEntry &entry = m_drawEntries[chunk->m_drawEntry];
+    entry = m_drawEntries.back();
+    entry.chunk->m_drawEntry = chunk->m_drawEntry;
+    m_drawEntries.pop_back();
+    chunk->m_drawEntry = -1;
+}
+
+void Terrain::draw(int minX, int maxX, int minZ, int maxZ, const Frustum &frustum, glm::vec3 eye,
+                   ShaderProgram *shaderProgram) {
+    QElapsedTimer timer;
+    timer.start();
+    m_drawStats = TerrainDrawStats();
 
-    for(int x = minX; x < maxX; x += Chunk::WIDTH)
+    glm::ivec4 area(floorDiv(minX, Chunk::WIDTH), floorDiv(maxX - 1, Chunk::WIDTH),
+                    floorDiv(minZ, Chunk::WIDTH), floorDiv(maxZ - 1, Chunk::WIDTH));
+    if (area != m_drawArea) {
+        m_drawArea = area;
+        for (ChunkDrawEntry &entry : m_drawEntries) {
+            int cx = floorDiv(entry.chunk->X, Chunk::WIDTH), cz = floorDiv(entry.chunk->Z, Chunk::WIDTH);
+            entry.inRange = cx >= area.x && cx <= area.y && cz >= area.z && cz <= area.w;
+        }
+    }
+    bool occlusion = findVisibleChunks(eye, frustum);
+
+    m_drawList.clear();
+    for (const ChunkDrawEntry &entry : m_drawEntries)
     {
-        for(int z = minZ; z < maxZ; z += Chunk::WIDTH)
-        {
-            int xFloor = static_cast<int>(glm::floor(x / (float) Chunk::WIDTH));
-            int zFloor = static_cast<int>(glm::floor(z / (float) Chunk::WIDTH));
+        // Only chunks in the grid around the player are drawn
+        if (!entry.inRange || m_chunkGrid[entry.gridCell] != entry.chunk) continue;
 
-            if (m_chunks.find(toKey(xFloor * Chunk::WIDTH, zFloor * Chunk::WIDTH)) == m_chunks.end())
-            { continue; }
+        ++m_drawStats.considered;
+        // test only the heights the chunk's mesh actually spans
+        if (!frustum.intersects(entry.boxMin, entry.boxMax)) {
+            ++m_drawStats.culled;
+            continue;
+        }
+        if (occlusion && !m_chunkReached[entry.gridCell]) {
+            ++m_drawStats.occluded;
+            continue;
+        }
 
-            const uPtr<Chunk> &chunk = m_chunks.at(toKey(xFloor * Chunk::WIDTH, zFloor * Chunk::WIDTH));
+        m_drawList.push_back(&entry);
+    }
+    m_drawStats.drawn = static_cast<int>(m_drawList.size());
 
-            if (!chunk->isBuffered) continue;
+    QElapsedTimer sortTimer;
+    sortTimer.start();
+    m_sortEye = eye;
+    glm::ivec3 eyeBlock(glm::floor(eye));
+    glm::ivec3 section(floorDiv(eyeBlock.x, Chunk::WIDTH), floorDiv(eyeBlock.y, SECTION_HEIGHT),
+                       floorDiv(eyeBlock.z, Chunk::WIDTH));
+    if (m_sortTransparentFaces && section != m_sortSection) {
+        m_sortSection = section;
+        for (const ChunkDrawEntry &entry : m_drawEntries) {
+            if (!entry.inRange || m_chunkGrid[entry.gridCell] != entry.chunk) continue;
+            int cx = floorDiv(entry.chunk->X, Chunk::WIDTH), cz = floorDiv(entry.chunk->Z, Chunk::WIDTH);
+            if (std::abs(cx - section.x) > TRANSPARENT_SORT_RADIUS
+                    || std::abs(cz - section.z) > TRANSPARENT_SORT_RADIUS) continue;
+            if (!entry.chunk->m_faceCentersTra.empty()) {
+                entry.chunk->sortTransparentFaces(eye);
+                ++m_drawStats.resorted;
+            }
+        }
+    }
 
-            chunks.push_back(chunk.get());
+    m_opaqueBatch.clear();
+    m_transparentBatch.clear();
+    m_transparentOrder.clear();
+    for (const ChunkDrawEntry *entry : m_drawList) {
+        if (entry->chunk->m_meshOpq.indices.size > 0) {
+            m_opaqueBatch.add(entry->chunk->m_meshOpq);
         }
+        if (entry->chunk->m_meshTra.indices.size > 0) {
+            // Chunks are columns on a grid, so the distance to their centre
+            // across x and z orders them
+            glm::vec2 d(entry->chunk->X + Chunk::WIDTH * 0.5f - eye.x, entry->chunk->Z + Chunk::WIDTH * 0.5f - eye.z);
+            m_transparentOrder.emplace_back(glm::dot(d, d), entry->chunk);
+        }
+    }
+    // Transparent meshes blend over what is behind them, so draw the farthest first
+    std::sort(m_transparentOrder.begin(), m_transparentOrder.end(),
+              [](const std::pair<float, const Chunk*> &a, const std::pair<float, const Chunk*> &b) {
+        return a.first > b.first;
+    });
+    for (auto &transparent : m_transparentOrder) {
+        m_transparentBatch.add(transparent.second->m_meshTra);
     }
+    m_drawStats.sortMs = sortTimer.nsecsElapsed() * 1e-6f;
 
     // draw opaque faces, with backface culling
     glEnable(GL_CULL_FACE);
-    for (auto& chunk : chunks) {
-        glm::mat4 matrix {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0},
-                     {chunk->X, 0, chunk->Z, 1}};
-
-        shaderProgram->setModelMatrix(matrix);
-        shaderProgram->drawInterleavedOpq(*chunk);
-    }
+    shaderProgram->drawArenaBatch(m_chunkArena, m_opaqueBatch);
 
     // draw transparent faces, without backface culling
     glDisable(GL_CULL_FACE);
-    for (auto& chunk : chunks) {
-        glm::mat4 matrix {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0},
-                     {chunk->X, 0, chunk->Z, 1}};
-
-        shaderProgram->setModelMatrix(matrix);
-        shaderProgram->drawInterleavedTra(*chunk);
-    }
+    shaderProgram->drawArenaBatch(m_chunkArena, m_transparentBatch);
 
     // turn it back on for later LOL
     glEnable(GL_CULL_FACE);
+
+    m_drawStats.cpuMs = timer.nsecsElapsed() * 1e-6f;
+}
+
+bool Terrain::findVisibleChunks(glm::vec3 eye, const Frustum &frustum) {
+    int eyeX = static_cast<int>(glm::floor(eye.x));
+    int eyeY = static_cast<int>(glm::floor(eye.y));
+    int eyeZ = static_cast<int>(glm::floor(eye.z));
+    if (eyeY < 0 || eyeY >= Chunk::HEIGHT) {
+        return false;
+    }
+    // A cell whose chunk isn't buffered draws nothing, so it can be seen
+    // straight through: every face of its sections joins every other
+    static const SectionConnectivity openSection = {0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f};
+    auto sectionFaces = [this](int cell, int sy) -> const SectionConnectivity& {
+        Chunk *c = m_chunkGrid[cell];
+        return c != nullptr && c->isBuffered ? c->m_sectionConnectivity[sy] : openSection;
+    };
+    int startX = floorDiv(eyeX, Chunk::WIDTH), startZ = floorDiv(eyeZ, Chunk::WIDTH);
+    if (!inChunkGrid(startX, startZ)) {
+        return false;
+    }
+
+    m_sectionReached.assign(m_chunkGrid.size() * SECTION_COUNT, false);
+    m_chunkReached.assign(m_chunkGrid.size(), false);
+    m_sectionQueue.clear();
+
+    // the camera's own section can see out of all of its faces
+    int startY = eyeY / SECTION_HEIGHT;
+    m_sectionReached[chunkGridIndex(startX, startZ) * SECTION_COUNT + startY] = true;
+    m_sectionQueue.push_back({startX, startY, startZ, -1, 0});
+
+    // Directions are ordered so that d ^ 1 is the opposite of d
+    static const glm::ivec3 steps[6] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+    for (size_t next = 0; next < m_sectionQueue.size(); ++next) {
+        SectionStep step = m_sectionQueue[next];
+        int cell = chunkGridIndex(step.cx, step.cz);
+        m_chunkReached[cell] = true;
+        const SectionConnectivity &faces = sectionFaces(cell, step.sy);
+
+        for (int d = 0; d < 6; ++d) {
+            // never head back toward the camera
+            if (step.directions & (1 << (d ^ 1))) continue;
+            if (step.entry >= 0 && !(faces[step.entry] & (1 << d))) continue;
+
+            int cx = step.cx + steps[d].x, sy = step.sy + steps[d].y, cz = step.cz + steps[d].z;
+            if (sy < 0 || sy >= SECTION_COUNT || !inChunkGrid(cx, cz)) continue;
+            int section = chunkGridIndex(cx, cz) * SECTION_COUNT + sy;
+            if (m_sectionReached[section]) continue;
+
+            glm::vec3 min(cx * Chunk::WIDTH, sy * SECTION_HEIGHT, cz * Chunk::WIDTH);
+            if (!frustum.intersects(min, min + glm::vec3(Chunk::WIDTH, SECTION_HEIGHT, Chunk::WIDTH))) continue;
+
+            m_sectionReached[section] = true;
+            m_sectionQueue.push_back({cx, sy, cz, d ^ 1, static_cast<unsigned char>(step.directions | (1 << d))});
+        }
+    }
+    return true;
+}
+
+const TerrainDrawStats& Terrain::getDrawStats() const {
+    return m_drawStats;
+}
+
+void Terrain::setTransparentFaceSorting(bool enabled) {
+    if (enabled == m_sortTransparentFaces) {
+        return;
+    }
+    m_sortTransparentFaces = enabled;
+    // re-sort for wherever the camera is on the next draw
+    m_sortSection = glm::ivec3(std::numeric_limits<int>::min());
+    for (auto &chunkPair : m_chunks) {
+        Chunk *c = chunkPair.second.get();
+        if (!enabled) {
+            // the face centers are only needed for sorting
+            std::vector<glm::vec3>().swap(c->m_faceCentersTra);
+        } else if (c->isBuffered && c->m_countTra > 0) {
+            // remesh the chunks with transparent faces, so they come back
+            // sorted and with their face centers
+            createVBOWorker(c);
+        }
+    }
+}
+
+ChunkArenaStats Terrain::getArenaStats() const {
+    return m_chunkArena.getStats();
 }
 
 void Terrain::multithread(glm::vec3 pos, glm::vec3 prevPos, float dT) {
@@ -243,22 +727,39 @@ void Terrain::tryNewChunk(glm::vec3 pos, glm::vec3 prevPos) {
     // Find the 64 x 64 zone the player is on
     glm::ivec2 curr(64.f * floor(pos.x/64.f), 64.f * floor(pos.z/64.f));
     glm::ivec2 prev(64.f * floor(prevPos.x/64.f), 64.f * floor(prevPos.z/64.f));
-    // Figure out which zones border this zone and the previous zone
-    QSet<long long> borderingCurr = borderingZone(curr, TERRAIN_CREATE_RADIUS, false);
-    QSet<long long> borderingPrev = borderingZone(prev, TERRAIN_CREATE_RADIUS, false);
+    // Keep the chunk grid centred on the player's zone
+    glm::ivec2 gridZone = (m_gridOrigin + glm::ivec2(TERRAIN_MAX_CREATE_RADIUS * 64 / Chunk::WIDTH)) * Chunk::WIDTH;
+    if (curr != gridZone) {
+        recenterChunkGrid(curr);
+    }
+    // Figure out which zones border this zone and the previous zone,
+    // at the radius each was buffered for
+    QSet<long long> borderingCurr = borderingZone(curr, m_createRadius, false);
+    QSet<long long> borderingPrev = borderingZone(prev, m_bufferedRadius, false);
+    m_bufferedRadius = m_createRadius;
     // If previous zones are no longer there, remove their vbo data
+    bool unloaded = false;
     for(long long zone : borderingPrev) {
-        if (!borderingCurr.contains(zone)) {
+        // zones the radius shrank past may never have been generated
+        if (!borderingCurr.contains(zone) && m_chunks.find(zone) != m_chunks.end()) {
+            unloaded = true;
             glm::ivec2 coord = toCoords(zone);
             for (int x = coord.x; x < coord.x + 64; x += 16) {
                 for(int z = coord.y; z < coord.y + 64; z += 16) {
                     auto& c = getChunkAt(x, z);
                     c->destroyVBOdata();
                     c->isBuffered = false;
+                    removeDrawEntry(c.get());
                 }
             }
         }
     }
+    // Only zones around the player are generated from now on, so forget
+    // the structures that can't reach them
+    if (unloaded) {
+        int reach = m_createRadius * 64;
+        m_structureRegistry.evictOutside(curr.x - reach, curr.y - reach, curr.x + reach + 64, curr.y + reach + 64);
+    }
     // Figure out if the current zones need VBO data or Block data
     for (long long zone: borderingCurr) {
         if (m_chunks.find(zone) != m_chunks.end()) {
@@ -277,6 +778,30 @@ void Terrain::tryNewChunk(glm::vec3 pos, glm::vec3 prevPos) {
     }
 }
 
+void Terrain::setCreateRadius(int radius) {
+    m_createRadius = glm::clamp(radius, 1, TERRAIN_MAX_CREATE_RADIUS);
+}
+
+int Terrain::getCreateRadius() const {
+    return m_createRadius;
+}
+
+float Terrain::getUploadMs() const {
+    return m_uploadMs;
+}
+
+bool Terrain::spawnAreaLoaded() const {
+    return !m_spawnLoading;
+}
+
+bool Terrain::inBufferedZones(const Chunk *chunk) const {
+    // The grid is centred on the player's zone as of the last zone check
+    glm::ivec2 playerZone = (m_gridOrigin + glm::ivec2(TERRAIN_MAX_CREATE_RADIUS * 64 / Chunk::WIDTH)) * Chunk::WIDTH;
+    glm::ivec2 zone(floorDiv(chunk->X, 64) * 64, floorDiv(chunk->Z, 64) * 64);
+    glm::ivec2 offset = glm::abs(zone - playerZone) / 64;
+    return glm::max(offset.x, offset.y) <= m_bufferedRadius;
+}
+
 QSet<long long> Terrain::borderingZone(glm::ivec2 coords, int radius, bool atEdge) {
     int radiusScale = radius * 64;
     QSet<long long> result;
@@ -303,23 +828,172 @@ void Terrain::checkThreadResults() {
     // First, send chunks processed by BlockWorkers to VBOWorkers
     if (!m_blockDataChunks.empty()) {
         m_blockDataChunksLock.lock();
+        for (Chunk *c : m_blockDataChunks) {
+            c->isGenerated = true;
+        }
+        if (m_spawnLoading) {
+            trackSpawnGenerated(m_blockDataChunks);
+        }
+        // Collect the neighbors separately, since inserting into the set
+        // while iterating over it can rehash it under the iterator
+        std::unordered_set<Chunk*> toMesh(m_blockDataChunks);
         for (auto &c : m_blockDataChunks) {
             for (auto& n : c->getNeighbors()) {
-                m_blockDataChunks.insert(n);
+                toMesh.insert(n);
             }
         }
-        createVBOWorkers(m_blockDataChunks);
+        createVBOWorkers(toMesh);
         m_blockDataChunks.clear();
         m_blockDataChunksLock.unlock();
     }
     // Second, take the chunks that have VBO data and send data to GPU
+    QElapsedTimer uploadTimer;
+    uploadTimer.start();
     m_VBODataChunksLock.lock();
     for (auto& data: m_vboDataChunks) {
+        // The player may have left the chunk's zone behind since it was
+        // queued; its mesh will be rebuilt if they come back
+        if (!inBufferedZones(data.mp_chunk)) {
+            if (m_spawnLoading) {
+                trackSpawnBuffered(data.mp_chunk);
+            }
+            continue;
+        }
+        data.mp_chunk->m_sectionConnectivity = data.m_sectionConnectivity;
         data.mp_chunk->bufferInterleavedVBOdata(data.m_idxDataOpaque, data.m_vboDataOpaque,
-                                                data.m_idxDataTransparent, data.m_vboDataTransparent);
+                                                data.m_idxDataTransparent, data.m_vboDataTransparent,
+                                                data.m_faceCentersTransparent);
+        updateDrawEntry(data.mp_chunk);
+        if (m_spawnLoading) {
+            trackSpawnBuffered(data.mp_chunk);
+        }
     }
     m_vboDataChunks.clear();
     m_VBODataChunksLock.unlock();
+    m_uploadMs = uploadTimer.nsecsElapsed() * 1e-6f;
+}
+
+void Terrain::loadSpawnArea(glm::vec3 pos) {
+    glm::ivec2 spawnZone(64.f * glm::floor(pos.x / 64.f), 64.f * glm::floor(pos.z / 64.f));
+    glm::ivec2 spawnChunk(Chunk::WIDTH * glm::floor(pos.x / Chunk::WIDTH),
+                          Chunk::WIDTH * glm::floor(pos.z / Chunk::WIDTH));
+    recenterChunkGrid(spawnZone);
+
+    // The chunks within one chunk of the spawn chunk, which the player
+    // can reach before anything else is needed
+    auto inNeighborhood = [&](int x, int z) {
+        return glm::abs(x - spawnChunk.x) <= Chunk::WIDTH && glm::abs(z - spawnChunk.y) <= Chunk::WIDTH;
+    };
+
+    // Order the zones by ring around the spawn zone, with the zones holding
+    // the rest of the spawn chunk's neighborhood right after the spawn zone.
+    // Each gets a lower priority than the last, and all of them a lower one
+    // than VBOWorkers, so finished chunks are meshed before farther zones
+    // start generating. Only the spawn zone's worker shares the VBOWorkers'
+    // priority.
+    QSet<long long> zones = borderingZone(spawnZone, m_createRadius, false);
+    m_bufferedRadius = m_createRadius;
+    std::vector<std::pair<int, long long>> ranks;
+    for (long long zone : zones) {
+        if (m_chunks.find(zone) != m_chunks.end()) {
+            continue;
+        }
+        glm::ivec2 corner = toCoords(zone);
+        glm::ivec2 offset = glm::abs(corner - spawnZone) / 64;
+        int rank = 2 * glm::max(offset.x, offset.y);
+        glm::ivec2 nearest = glm::clamp(spawnChunk, corner, corner + glm::ivec2(64 - Chunk::WIDTH));
+        if (rank > 0 && inNeighborhood(nearest.x, nearest.y)) {
+            rank = 1;
+        }
+        ranks.push_back({rank, zone});
+    }
+    std::sort(ranks.begin(), ranks.end());
+
+    m_spawnLoading = true;
+    m_spawnLoadTimer.start();
+    m_spawnChunkGenerated = false;
+    m_spawnAreaChunks.clear();
+    m_spawnChunksMeshing.clear();
+    m_spawnNeighborhood.clear();
+    mp_spawnChunk = nullptr;
+    for (auto &rank : ranks) {
+        glm::ivec2 corner = toCoords(rank.second);
+        // the spawn chunk, then the rest of its neighborhood, then everything else
+        std::vector<Chunk*> toDo, rest;
+        for (int x = corner.x; x < corner.x + 64; x += 16) {
+            for (int z = corner.y; z < corner.y + 64; z += 16) {
+                Chunk *c = instantiateChunkAt(x, z, false);
+                m_spawnAreaChunks.insert(c);
+                if (glm::ivec2(x, z) == spawnChunk) {
+                    mp_spawnChunk = c;
+                    toDo.insert(toDo.begin(), c);
+                } else if (inNeighborhood(x, z)) {
+                    toDo.push_back(c);
+                } else {
+                    rest.push_back(c);
+                }
+                if (inNeighborhood(x, z)) {
+                    m_spawnNeighborhood.insert(c);
+                }
+            }
+        }
+        toDo.insert(toDo.end(), rest.begin(), rest.end());
+        if (rank.first == 0) {
+            // The spawn zone's worker hands the spawn chunk over as soon as
+            // it is done, so it can be meshed without waiting for the rest
+            // of the zone, which shares its climate map
+            startBDWorker(corner.x, corner.y, toDo, 0, true);
+        } else {
+            startBDWorker(corner.x, corner.y, toDo, -1 - rank.first);
+        }
+    }
+    m_spawnChunksGenerating = m_spawnAreaChunks.size();
+    m_chunkArena.reserve(m_spawnAreaChunks.size());
+    // the spawn zone was already loaded
+    m_spawnChunkGenerated = mp_spawnChunk == nullptr;
+    if (m_spawnAreaChunks.empty()) {
+        m_spawnLoading = false;
+    }
+}
+
+bool Terrain::spawnNeighborhoodGenerated() const {
+    return !m_spawnLoading || m_spawnNeighborhood.empty();
+}
+
+void Terrain::trackSpawnGenerated(const std::unordered_set<Chunk*> &generated) {
+    for (Chunk *c : generated) {
+        if (!m_spawnAreaChunks.count(c)) {
+            continue;
+        }
+        --m_spawnChunksGenerating;
+        if (c == mp_spawnChunk) {
+            m_spawnChunkGenerated = true;
+        }
+        m_spawnNeighborhood.erase(c);
+        // it and its neighbors are about to be (re)meshed
+        m_spawnChunksMeshing.insert(c);
+        for (Chunk *n : c->getNeighbors()) {
+            if (m_spawnAreaChunks.count(n)) {
+                m_spawnChunksMeshing.insert(n);
+            }
+        }
+    }
+}
+
+void Terrain::trackSpawnBuffered(Chunk* chunk) {
+    if (chunk == mp_spawnChunk && m_spawnChunkGenerated) {
+        printf("Spawn chunk ready after %lld ms\n", m_spawnLoadTimer.elapsed());
+        mp_spawnChunk = nullptr;
+    }
+    m_spawnChunksMeshing.erase(chunk);
+    // Done once every chunk has been generated and its final mesh,
+    // built with all of its neighbors present, has been buffered
+    if (m_spawnChunksGenerating == 0 && m_spawnChunksMeshing.empty()) {
+        printf("Spawn area of %zu chunks ready after %lld ms\n",
+               m_spawnAreaChunks.size(), m_spawnLoadTimer.elapsed());
+        m_spawnLoading = false;
+        m_spawnAreaChunks.clear();
+    }
 }
 
 void Terrain::CreateTestScene()
@@ -329,7 +1003,8 @@ void Terrain::CreateTestScene()
     // initial world space
     for(int x = 0; x < 64; x += Chunk::WIDTH) {
         for(int z = 0; z < 64; z += Chunk::WIDTH) {
-            instantiateChunkAt(x, z, false);
+            // filled in by hand below
+            instantiateChunkAt(x, z, false)->isGenerated = true;
         }
     }
     // Tell our existing terrain set that
@@ -363,7 +1038,7 @@ void Terrain::createBDWorkers(const QSet<long long> &zones) {
     }
 }
 
-void Terrain::createBDWorker(long long zone) {
+void Terrain::createBDWorker(long long zone, int priority) {
     std::vector<Chunk*> toDo;
     int x = toCoords(zone).x;
     int z = toCoords(zone).y;
@@ -372,9 +1047,15 @@ void Terrain::createBDWorker(long long zone) {
             toDo.push_back(instantiateChunkAt(i, j, false));
         }
     }
+    startBDWorker(x, z, toDo, priority);
+}
+
+void Terrain::startBDWorker(int x, int z, const std::vector<Chunk*> &toDo, int priority,
+                            bool publishFirst) {
     BDWorker *worker = new BDWorker(x, z, toDo,
-                                    &m_blockDataChunks, &m_blockDataChunksLock);
-    QThreadPool::globalInstance()->start(worker);
+                                    &m_blockDataChunks, &m_blockDataChunksLock,
+                                    &m_structureRegistry, publishFirst);
+    QThreadPool::globalInstance()->start(worker, priority);
 }
 
 void Terrain::createVBOWorkers(const std::unordered_set<Chunk*> &chunks) {
@@ -384,6 +1065,15 @@ void Terrain::createVBOWorkers(const std::unordered_set<Chunk*> &chunks) {
 }
 
 void Terrain::createVBOWorker(Chunk* chunk) {
-    VBOWorker *worker = new VBOWorker(chunk, &m_vboDataChunks, &m_VBODataChunksLock);
+    // Its BDWorker may still be writing its blocks; it gets meshed once
+    // checkThreadResults sees them land
+    if (!chunk->isGenerated) {
+        return;
+    }
+    std::optional<glm::vec3> sortEye;
+    if (m_sortTransparentFaces) {
+        sortEye = m_sortEye;
+    }
+    VBOWorker *worker = new VBOWorker(chunk, &m_vboDataChunks, &m_VBODataChunksLock, sortEye);
     QThreadPool::globalInstance()->start(worker);
 }
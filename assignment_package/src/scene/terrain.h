@@ -2,11 +2,16 @@
 #include "smartpointerhelp.h"
 #include "glm_includes.h"
 #include "chunk.h"
+#include "chunkarena.h"
+#include "structureregistry.h"
+#include "frustum.h"
 #include <array>
+#include <optional>
 #include <unordered_map>
 #include <unordered_set>
 #include "shaderprogram.h"
 #include <QMutex>
+#include <QElapsedTimer>
 
 
 //using namespace std;
@@ -15,8 +20,80 @@
 int64_t toKey(int x, int z);
 glm::ivec2 toCoords(int64_t k);
 
-// Number of 64 x 64 zones to draw
+// Number of 64 x 64 zones to generate on each side of the player's,
+// until setCreateRadius picks another, and the most it can pick
 #define TERRAIN_CREATE_RADIUS 2
+#define TERRAIN_MAX_CREATE_RADIUS 3
+// Width, in chunks, of the ring-buffer grid that mirrors the loaded zones
+// around the player: (2 * radius + 1) zones of 4 chunks each, at the
+// largest radius
+#define TERRAIN_GRID_WIDTH ((2 * TERRAIN_MAX_CREATE_RADIUS + 1) * 4)
+// Chunks within this many chunks of the camera have their transparent
+// faces re-sorted whenever the camera enters a new section. Farther ones
+// keep the order they were meshed in, which is rarely visibly wrong.
+#define TRANSPARENT_SORT_RADIUS 4
+
+// A batch of block edits to apply to the Terrain all at once.
+// Edits are only recorded here. Terrain::commitEdits applies them and
+// remeshes every chunk they dirtied exactly once, so large edits such as
+// explosions or pasted structures don't remesh a chunk per block.
+class BlockEditBatch {
+private:
+    // Sets every block in [min, max) to type. A single block is a
+    // one-block region.
+    struct Edit {
+        glm::ivec3 min, max;
+        BlockType type;
+    };
+    std::vector<Edit> m_edits;
+
+    friend class Terrain;
+
+public:
+    // Record setting the block at these world-space coords to t.
+    // Later edits to the same block win.
+    void setBlockAt(int x, int y, int z, BlockType t);
+    // Record setting every block in the region (min inclusive,
+    // max exclusive) to t
+    void fillRegion(glm::ivec3 min, glm::ivec3 max, BlockType t);
+
+    bool empty() const;
+    // The number of edits recorded, counting each region as one
+    size_t size() const;
+    void clear();
+};
+
+// What Terrain::draw did with the buffered chunks in its last call
+struct TerrainDrawStats {
+    // Buffered chunks with a non-empty mesh inside the draw area
+    int considered = 0;
+    // ...that were skipped because their box was outside the view frustum
+    int culled = 0;
+    // ...that were inside the frustum but hidden from the camera's section
+    // behind opaque blocks, according to the section connectivity graph
+    int occluded = 0;
+    // ...and that were drawn
+    int drawn = 0;
+    // Chunks whose transparent faces were re-sorted because the camera
+    // entered a new section
+    int resorted = 0;
+    // CPU time spent in draw, in milliseconds, including issuing the GL calls
+    float cpuMs = 0.f;
+    // ...of which sorting transparent chunks and faces took this much
+    float sortMs = 0.f;
+};
+
+// A buffered Chunk with a non-empty mesh, along with everything
+// Terrain::draw needs to cull and draw it, computed when it is uploaded
+struct ChunkDrawEntry {
+    Chunk* chunk;
+    // Its cell in the Terrain's chunk grid
+    int gridCell;
+    // World-space box around its mesh
+    glm::vec3 boxMin, boxMax;
+    // Does it overlap the draw area of the last call to draw?
+    bool inRange;
+};
 
 // The container class for all of the Chunks in the game.
 // Ultimately, while Terrain will always store all Chunks,
@@ -46,11 +123,27 @@ private:
     // in the Terrain will never be deleted until the program is terminated.
     std::unordered_set<int64_t> m_generatedTerrain;
 
+    // Toroidal grid of Chunk pointers covering the zones around the player.
+    // A chunk at chunk-space coords (cx, cz) lives in cell
+    // (cx mod TERRAIN_GRID_WIDTH, cz mod TERRAIN_GRID_WIDTH) as long as it
+    // lies within the window starting at m_gridOrigin, so lookups near the
+    // player are an index computation instead of a hash. m_chunks still owns
+    // every Chunk and is used as a fallback outside the window.
+    std::array<Chunk*, TERRAIN_GRID_WIDTH * TERRAIN_GRID_WIDTH> m_chunkGrid;
+    // Chunk-space coords of the lower-left chunk of the grid window
+    glm::ivec2 m_gridOrigin;
+
     OpenGLContext* mp_context;
 
     // -- MULTITHREADING --
     // Timer to check if new chunks should be loaded or not
     float m_newChunkTimer;
+    // Zones to generate on each side of the player's, and the radius the
+    // buffered zones were last updated for
+    int m_createRadius;
+    int m_bufferedRadius;
+    // Time the last call to multithread spent uploading meshes, in ms
+    float m_uploadMs;
 
     // Check if there should be new chunks computed
     void tryNewChunk(glm::vec3 pos, glm::vec3 prevPos);
@@ -65,11 +158,127 @@ private:
     // Vector and mutex of chunks that have VBO data
     std::vector<ChunkVBOdata> m_vboDataChunks;
     QMutex m_VBODataChunksLock;
+    // Structure placements resolved so far, shared by every BDWorker
+    StructureRegistry m_structureRegistry;
+
+    // Counters from the last call to draw
+    TerrainDrawStats m_drawStats;
+
+    // -- DRAW LIST --
+    // Every buffered chunk with a non-empty mesh, packed together.
+    // Entries are added or refreshed when a chunk's mesh is uploaded and
+    // removed when it is evicted, so draw never searches for chunks.
+    std::vector<ChunkDrawEntry> m_drawEntries;
+    // The entries draw is drawing this frame. Kept between frames so it
+    // doesn't reallocate.
+    std::vector<const ChunkDrawEntry*> m_drawList;
+    // Range of chunk-space coords (min x, max x, min z, max z, inclusive)
+    // overlapping the last draw area. inRange is only recomputed when
+    // the player crosses into a new chunk and this changes.
+    glm::ivec4 m_drawArea;
+    // Vertex and index buffers every chunk mesh is buffered into
+    ChunkArena m_chunkArena;
+    // The draw list's opaque and transparent meshes, drawn with one call
+    // each. Kept between frames so they don't reallocate.
+    ArenaDrawBatch m_opaqueBatch, m_transparentBatch;
+    // Distance squared from the camera and chunk of each transparent mesh
+    // in the draw list, sorted farthest first. Kept between frames.
+    std::vector<std::pair<float, const Chunk*>> m_transparentOrder;
+
+    // -- TRANSPARENT FACE SORTING --
+    // Are transparent faces sorted back to front within each chunk?
+    bool m_sortTransparentFaces;
+    // Camera position of the last call to draw, which new meshes are sorted for
+    glm::vec3 m_sortEye;
+    // Section the camera was in when faces were last re-sorted
+    glm::ivec3 m_sortSection;
+
+    // Adds or refreshes the chunk's draw entry after its mesh is uploaded
+    void updateDrawEntry(Chunk* chunk);
+    // Drops the chunk's draw entry, if it has one
+    void removeDrawEntry(Chunk* chunk);
+
+    // -- OCCLUSION CULLING --
+    // A step of the search through the section graph: a section, the face
+    // it was entered through, and every Direction taken to reach it
+    struct SectionStep {
+        int cx, sy, cz;
+        int entry;
+        unsigned char directions;
+    };
+    // Per-frame scratch for findVisibleChunks, indexed by chunk grid cell
+    // (times SECTION_COUNT, plus the section, for the sections)
+    std::vector<bool> m_sectionReached;
+    std::vector<bool> m_chunkReached;
+    std::vector<SectionStep> m_sectionQueue;
+
+    // Searches the sections reachable from the one containing eye, through
+    // faces that are joined by non-opaque blocks, never doubling back
+    // toward the camera and skipping sections outside the frustum. Sets
+    // m_chunkReached for every grid cell with a reached section. Cells
+    // without a buffered chunk are open on every face; only the edge of
+    // the grid stops the search. Returns false, leaving everything
+    // visible, if eye isn't inside the grid.
+    bool findVisibleChunks(glm::vec3 eye, const Frustum &frustum);
+
+    // -- STARTUP LOAD --
+    // Progress of the load started by loadSpawnArea, until every chunk
+    // around the spawn point has been generated and buffered
+    bool m_spawnLoading;
+    QElapsedTimer m_spawnLoadTimer;
+    // The chunk the player spawns in, and whether its blocks exist yet
+    Chunk* mp_spawnChunk;
+    bool m_spawnChunkGenerated;
+    // The spawn chunk and the chunks around it whose blocks don't exist yet
+    std::unordered_set<Chunk*> m_spawnNeighborhood;
+    // Every chunk of the spawn area, how many of them are still generating,
+    // and which are waiting on a VBOWorker
+    std::unordered_set<Chunk*> m_spawnAreaChunks;
+    size_t m_spawnChunksGenerating;
+    std::unordered_set<Chunk*> m_spawnChunksMeshing;
+
+    // Updates the startup load with chunks that finished generating or
+    // were just buffered, and reports the load times when it is done
+    void trackSpawnGenerated(const std::unordered_set<Chunk*> &generated);
+    void trackSpawnBuffered(Chunk* chunk);
+
+    // Is the chunk in one of the zones buffered around the player's?
+    bool inBufferedZones(const Chunk *chunk) const;
+    // Re-anchor the chunk grid so it is centred on the given zone
+    void recenterChunkGrid(glm::ivec2 zone);
+    // Is this chunk-space coordinate inside the grid window?
+    bool inChunkGrid(int cx, int cz) const;
+    // Grid cell index for a chunk-space coordinate inside the window
+    int chunkGridIndex(int cx, int cz) const;
+
+    // Calls f(chunk, run, length, start) for every row of blocks along x
+    // where the region overlaps an existing Chunk. run points into the
+    // Chunk's block array, or is nullptr if the row is outside 0..HEIGHT.
+    template <typename F>
+    void forEachRegionRun(glm::ivec3 min, glm::ivec3 max, F &&f) const;
+    // Adds c to the dirty set, along with any neighbors that share a face
+    // with the local x-z rectangle [minX, maxX] x [minZ, maxZ] that changed
+    static void markDirty(std::unordered_set<Chunk*> &dirty, Chunk *c,
+                          int minX, int maxX, int minZ, int maxZ);
+    // Moves the chunkLock held by an edit from the chunk in held to c
+    // (nullptr to just release it), so a VBOWorker can't mesh a chunk
+    // while its blocks are being written
+    static void holdChunkLock(Chunk *&held, Chunk *c);
+    // Sends every buffered chunk in the set to a VBOWorker for remeshing.
+    // Returns the number of chunks sent.
+    size_t remeshChunks(const std::unordered_set<Chunk*> &chunks);
 
     // Spawn Workers
     void createBDWorkers(const QSet<long long> &zones);
+    // Chunks that haven't been generated yet are skipped; they are meshed
+    // when their blocks land.
     void createVBOWorkers(const std::unordered_set<Chunk*> &chunks);
     void createVBOWorker(Chunk* chunk);
+    // Queues a BDWorker for chunks of the zone with its corner at (x, z).
+    // With publishFirst, the first chunk is handed back as soon as it is
+    // generated instead of along with the rest.
+    void startBDWorker(int x, int z, const std::vector<Chunk*> &toDo, int priority,
+                       bool publishFirst = false);
 
 
 public:
@@ -83,6 +292,14 @@ public:
     // Do these world-space coordinates lie within
     // a Chunk that exists?
     bool hasChunkAt(int x, int z) const;
+    // Return the Chunk containing these world-space coords,
+    // or nullptr if none exists. Checks the chunk grid first
+    // and falls back to the hash map.
+    Chunk* findChunkAt(int x, int z) const;
+    // Like findChunkAt, but also nullptr while the Chunk's blocks are
+    // still being generated. The block query, edit and region functions
+    // below all use this, so they treat such Chunks as missing.
+    Chunk* findGeneratedChunkAt(int x, int z) const;
     // Assuming a Chunk exists at these coords,
     // return a mutable reference to it
     uPtr<Chunk>& getChunkAt(int x, int z);
@@ -93,11 +310,51 @@ public:
     // values) return the block stored at that point in space.
     BlockType getBlockAt(int x, int y, int z) const;
     BlockType getBlockAt(glm::vec3 p) const;
+    // Non-throwing version of getBlockAt for per-frame code.
+    // Returns std::nullopt if there is no generated Chunk at these coordinates.
+    std::optional<BlockType> queryBlockAt(int x, int y, int z) const;
+    std::optional<BlockType> queryBlockAt(glm::vec3 p) const;
+    // Looks up count blocks at once, writing the block at positions[i]
+    // to out[i], or missing if there is no Chunk there. Runs of positions
+    // in the same Chunk reuse the previous Chunk lookup.
+    void queryBlocksAt(const glm::ivec3 *positions, size_t count,
+                       BlockType *out, BlockType missing) const;
     // Given a world-space coordinate (which may have negative
     // values) set the block at that point in space to the
     // given type.
     void setBlockAt(int x, int y, int z, BlockType t);
 
+    // Applies every edit in the batch, in order, skipping edits in missing
+    // chunks or outside 0..HEIGHT, then sends each dirty chunk to a
+    // VBOWorker once. Neighbors are included when an edit lies on a chunk
+    // border. Regions are written a row at a time. Each chunk's chunkLock
+    // is held while its blocks are written, so a VBOWorker meshing it
+    // never sees half an edit. Returns the number of chunks queued for
+    // remeshing.
+    size_t commitEdits(BlockEditBatch &batch);
+
+    // -- REGION EDITING --
+    // Regions are axis-aligned boxes of world-space blocks, with min inclusive
+    // and max exclusive. Dense buffers are laid out x-fastest, then y, then z,
+    // so they hold (max - min).x * (max - min).y * (max - min).z blocks.
+    // Blocks in missing chunks, including ones still being generated, are
+    // skipped when writing.
+    // Writers hold each chunk's chunkLock while they write into it, and
+    // remesh every chunk they changed (plus bordering neighbors) once,
+    // through the worker pool after all edits are done, unless remesh is false.
+
+    // Reads the region into out, setting blocks in missing chunks to missing
+    void readRegion(glm::ivec3 min, glm::ivec3 max, BlockType *out, BlockType missing) const;
+    // Writes a dense buffer into the region
+    void writeRegion(glm::ivec3 min, glm::ivec3 max, const BlockType *data, bool remesh = true);
+    // Sets every block in the region to t
+    void fillRegion(glm::ivec3 min, glm::ivec3 max, BlockType t, bool remesh = true);
+    // Sets every block of type from in the region to type to
+    void replaceRegion(glm::ivec3 min, glm::ivec3 max, BlockType from, BlockType to, bool remesh = true);
+    // Copies the source region so its min corner lands on dstMin.
+    // Overlapping source and destination regions are handled correctly.
+    void copyRegion(glm::ivec3 srcMin, glm::ivec3 srcMax, glm::ivec3 dstMin, bool remesh = true);
+
     // checks for nearby unloaded chunks, and if they don't exist,
     // generates + creates VBOs for them and all touching chunks.
     void initializeNearbyChunks(int x, int z, int distance, bool init);
@@ -105,16 +362,48 @@ public:
     // create all chunk vbo data
     void createAllChunkVBOdata();
 
-    // creates a block data worker
-    void createBDWorker(long long zone);
+    // creates a block data worker. Workers with a higher priority
+    // leave the thread pool's queue first.
+    void createBDWorker(long long zone, int priority = 0);
+
+    // Generates and meshes the zones around pos on the thread pool,
+    // nearest zone first, so the spawn chunk appears as soon as it is
+    // ready and the rest streams in behind it. The spawn zone is generated
+    // by a single worker that hands the spawn chunk over first. Prints the
+    // time until the spawn chunk is buffered and until the whole area is.
+    void loadSpawnArea(glm::vec3 pos);
+    // Have the blocks of the spawn chunk and the eight chunks around it
+    // been generated, so the player can't walk off into a missing one?
+    // Always true once the startup load is over.
+    bool spawnNeighborhoodGenerated() const;
 
     // Draws every Chunk that falls within the bounding box
-    // described by the min and max coords, using the provided
-    // ShaderProgram
-    void draw(int minX, int maxX, int minZ, int maxZ, ShaderProgram *shaderProgram);
+    // described by the min and max coords, overlaps the view
+    // frustum and isn't walled off from the camera at eye,
+    // using the provided ShaderProgram
+    void draw(int minX, int maxX, int minZ, int maxZ, const Frustum &frustum, glm::vec3 eye,
+              ShaderProgram *shaderProgram);
+    // Counters from the last call to draw
+    const TerrainDrawStats& getDrawStats() const;
+    // Turns sorting transparent faces within each chunk on or off.
+    // Chunks themselves are always drawn back to front. Turning it off
+    // frees the face centers kept for re-sorting; turning it back on
+    // remeshes the buffered chunks with transparent faces to rebuild them.
+    void setTransparentFaceSorting(bool enabled);
+    // How full and fragmented the chunk mesh buffers are
+    ChunkArenaStats getArenaStats() const;
 
     // Starts the multithreading process that generates the terrain
     void multithread(glm::vec3 pos, glm::vec3 prevPos, float dT);
+    // Changes how many zones are generated and buffered on each side of
+    // the player's, from 1 to TERRAIN_MAX_CREATE_RADIUS. Zones are loaded
+    // or unloaded to match on the next zone check.
+    void setCreateRadius(int radius);
+    int getCreateRadius() const;
+    // Time the last call to multithread spent uploading meshes, in ms
+    float getUploadMs() const;
+    // Has the startup load begun by loadSpawnArea finished?
+    bool spawnAreaLoaded() const;
 
     // Initializes the Chunks that store the 64 x 256 x 64 block scene you
     // see when the base code is run.
@@ -1,25 +1,38 @@
 #include "workers.h"
 #include "noise.h"
+#include "climatemap.h"
 
 BDWorker::BDWorker(int x, int z, std::vector<Chunk*> toDo,
-                   std::unordered_set<Chunk*>* complete, QMutex* completedLock) :
-    m_xCorner(x), m_zCorner(z), m_chunksToDo(toDo), mp_chunksDone(complete), mp_chunksCompletedLock(completedLock)
+                   std::unordered_set<Chunk*>* complete, QMutex* completedLock,
+                   StructureRegistry* structures, bool publishFirst) :
+    m_xCorner(x), m_zCorner(z), m_chunksToDo(toDo), mp_chunksDone(complete), mp_chunksCompletedLock(completedLock),
+    mp_structures(structures), m_publishFirst(publishFirst)
 {}
 
 void BDWorker::run() {
+    // Compute the zone's climate once and share it with all its chunks
+    ClimateMap climate(m_xCorner, m_zCorner, 64);
     // Construct chunks to do
+    size_t published = 0;
     for (Chunk* c : m_chunksToDo) {
-        c->generateTerrain();
+        c->generateTerrain(&climate, mp_structures);
+        if (m_publishFirst && published == 0) {
+            mp_chunksCompletedLock->lock();
+            mp_chunksDone->insert(c);
+            mp_chunksCompletedLock->unlock();
+            published = 1;
+        }
     }
     mp_chunksCompletedLock->lock();
-    for (Chunk* c : m_chunksToDo) {
-        mp_chunksDone->insert(c);
+    for (size_t i = published; i < m_chunksToDo.size(); ++i) {
+        mp_chunksDone->insert(m_chunksToDo[i]);
     }
     mp_chunksCompletedLock->unlock();
 }
 
-VBOWorker::VBOWorker(Chunk* c, std::vector<ChunkVBOdata>* data, QMutex *dataLock) :
-    mp_chunk(c), mp_VBOsCompleted(data), mp_VBOsCompletedLock(dataLock)
+VBOWorker::VBOWorker(Chunk* c, std::vector<ChunkVBOdata>* data, QMutex *dataLock,
+                     std::optional<glm::vec3> sortEye) :
+    mp_chunk(c), mp_VBOsCompleted(data), mp_VBOsCompletedLock(dataLock), m_sortEye(sortEye)
 {}
 
 void VBOWorker::run() {
@@ -28,6 +41,13 @@ void VBOWorker::run() {
     // call function to build VBO Data
     mp_chunk->getInterleavedVBOdata(c.m_idxDataOpaque, c.m_vboDataOpaque,
                                     c.m_idxDataTransparent, c.m_vboDataTransparent);
+    // Transparent faces blend in the order they're drawn, so the farthest go first
+    if (m_sortEye && !c.m_idxDataTransparent.empty()) {
+        Chunk::getFaceCenters(c.m_vboDataTransparent, c.m_faceCentersTransparent);
+        Chunk::sortFacesBackToFront(c.m_idxDataTransparent, c.m_faceCentersTransparent,
+                                    *m_sortEye - glm::vec3(mp_chunk->X, 0, mp_chunk->Z));
+    }
+    mp_chunk->getSectionConnectivity(c.m_sectionConnectivity);
     mp_VBOsCompletedLock->lock();
     mp_VBOsCompleted->push_back(c);
     mp_VBOsCompletedLock->unlock();
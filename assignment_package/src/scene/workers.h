@@ -1,7 +1,9 @@
 #pragma once
 #include "chunk.h"
+#include "structureregistry.h"
 #include <QRunnable>
 #include <QMutex>
+#include <optional>
 #include <unordered_set>
 
 class BDWorker : public QRunnable {
@@ -10,10 +12,15 @@ private:
     std::vector<Chunk*> m_chunksToDo;
     std::unordered_set<Chunk*>* mp_chunksDone;
     QMutex* mp_chunksCompletedLock;
+    StructureRegistry* mp_structures;
+    // Hand the first chunk over as soon as it is generated, so it can be
+    // meshed while the rest of the zone generates
+    bool m_publishFirst;
 
 public:
     BDWorker(int x, int z, std::vector<Chunk*> toDo,
-             std::unordered_set<Chunk*>* complete, QMutex* completed);
+             std::unordered_set<Chunk*>* complete, QMutex* completed,
+             StructureRegistry* structures, bool publishFirst = false);
     void run() override;
 
 };
@@ -23,8 +30,12 @@ private:
     Chunk* mp_chunk;
     std::vector<ChunkVBOdata>* mp_VBOsCompleted;
     QMutex* mp_VBOsCompletedLock;
+    // If set, transparent faces are sorted back to front from this
+    // world-space camera position
+    std::optional<glm::vec3> m_sortEye;
 
 public:
-    VBOWorker(Chunk* c, std::vector<ChunkVBOdata>* data, QMutex* lock);
+    VBOWorker(Chunk* c, std::vector<ChunkVBOdata>* data, QMutex* lock,
+              std::optional<glm::vec3> sortEye = std::nullopt);
     void run() override;
 };
@@ -1,4 +1,5 @@
 #include "shaderprogram.h"
+#include "frameuniforms.h"
 #include <QFile>
 #include <QStringBuilder>
 #include <QTextStream>
@@ -10,8 +11,8 @@
 ShaderProgram::ShaderProgram(OpenGLContext *context)
     : vertShader(), fragShader(), prog(),
       attrPos(-1), attrNor(-1), attrUV(-1),
-      unifModel(-1), unifModelInvTr(-1), unifViewProj(-1),
-      unifSampler2D(-1), unifTimeOfDay(-1),
+      unifModel(-1), unifModelInvTr(-1),
+      unifSampler2D(-1), unifDimensions(-1),
       context(context)
 {}
 
@@ -51,6 +52,10 @@ void ShaderProgram::create(const char *vertfile, const char *fragfile)
     // Tell prog that it manages these particular vertex and fragment shaders
     context->glAttachShader(prog, vertShader);
     context->glAttachShader(prog, fragShader);
+    // Pin the attributes meshes are laid out with, see drawable.h
+    context->glBindAttribLocation(prog, ATTR_POS_LOCATION, "vs_Pos");
+    context->glBindAttribLocation(prog, ATTR_NOR_LOCATION, "vs_Nor");
+    context->glBindAttribLocation(prog, ATTR_UV_LOCATION, "vs_UV");
     context->glLinkProgram(prog);
 
     // Check for linking success
@@ -71,14 +76,16 @@ void ShaderProgram::create(const char *vertfile, const char *fragfile)
 
     unifModel      = context->glGetUniformLocation(prog, "u_Model");
     unifModelInvTr = context->glGetUniformLocation(prog, "u_ModelInvTr");
-    unifViewProj   = context->glGetUniformLocation(prog, "u_ViewProj");
 
     unifSampler2D  = context->glGetUniformLocation(prog, "u_Texture");
     unifDimensions = context->glGetUniformLocation(prog, "u_Dimensions");
-    unifEye        = context->glGetUniformLocation(prog, "u_Eye");
-    unifTime       = context->glGetUniformLocation(prog, "u_Time");
-    unifWeather    = context->glGetUniformLocation(prog, "u_Weather");
-    unifTimeOfDay  = context->glGetUniformLocation(prog, "u_TimeOfDay");
+
+    // The camera, clock and weather live in the shared FrameUniforms block,
+    // which MyGL uploads once per frame for every program
+    GLuint frameBlock = context->glGetUniformBlockIndex(prog, "FrameUniforms");
+    if (frameBlock != GL_INVALID_INDEX) {
+        context->glUniformBlockBinding(prog, frameBlock, FRAME_UNIFORMS_BINDING);
+    }
 }
 
 void ShaderProgram::useMe()
@@ -116,33 +123,6 @@ void ShaderProgram::setModelMatrix(const glm::mat4 &model)
     }
 }
 
-void ShaderProgram::setViewProjMatrix(const glm::mat4 &vp)
-{
-    // Tell OpenGL to use this shader program for subsequent function calls
-    useMe();
-
-    if(unifViewProj != -1) {
-    // Pass a 4x4 matrix into a uniform variable in our shader
-                    // Handle to the matrix variable on the GPU
-    context->glUniformMatrix4fv(unifViewProj,
-                    // How many matrices to pass
-                       1,
-                    // Transpose the matrix? OpenGL uses column-major, so no.
-                       GL_FALSE,
-                    // Pointer to the first element of the matrix
-                       &vp[0][0]);
-    }
-}
-
-void ShaderProgram::setTime(int time)
-{
-    useMe();
-
-    if (unifTime != -1) {
-        context->glUniform1i(unifTime, time);
-    }
-}
-
 void ShaderProgram::setTexture(int t)
 {
     useMe();
@@ -153,15 +133,6 @@ void ShaderProgram::setTexture(int t)
     }
 }
 
-void ShaderProgram::setTimeOfDay(float hours)
-{
-    useMe();
-
-    if (unifTimeOfDay != -1) {
-        context->glUniform1f(unifTimeOfDay, hours);
-    }
-}
-
 //This function, as its name implies, uses the passed in GL widget
 void ShaderProgram::drawOpq(Drawable &d, int i = 0)
 {
@@ -302,84 +273,60 @@ void ShaderProgram::drawInstancedOpq(InstancedDrawable &d)
 
 }
 
-void ShaderProgram::drawInterleavedOpq(Drawable &d)
+void ShaderProgram::drawInstancedTra(InstancedDrawable &d, int textureSlot)
 {
     useMe();
 
-    if (d.elemCountOpq() < 0) {
-        throw std::out_of_range("Attempting to draw a drawable with m_count of " + std::to_string(d.elemCountOpq()) + "!");
+    if(d.elemCountTra() < 0) {
+        throw std::out_of_range("Attempting to draw a drawable with m_count of " + std::to_string(d.elemCountTra()) + "!");
     }
 
-    setTexture(0);
+    setTexture(textureSlot);
 
-    const long long hop = 3 * sizeof(glm::vec4);
+    if (attrPos != -1 && d.bindPosTra()) {
+        context->glEnableVertexAttribArray(attrPos);
+        context->glVertexAttribPointer(attrPos, 4, GL_FLOAT, false, 0, NULL);
+    }
 
-    // we only use the pos VBO
-    if (d.bindPosOpq()) {
-        if (attrPos != -1) {
-            context->glEnableVertexAttribArray(attrPos);
-            context->glVertexAttribPointer(attrPos, 4, GL_FLOAT, false, hop, (void*)0);
-        }
+    if (attrUV != -1 && d.bindUVTra()) {
+        context->glEnableVertexAttribArray(attrUV);
+        context->glVertexAttribPointer(attrUV, 2, GL_FLOAT, false, 0, NULL);
+    }
 
-        if (attrNor != -1) {
-            context->glEnableVertexAttribArray(attrNor);
-            context->glVertexAttribPointer(attrNor, 4, GL_FLOAT, false, hop, (void*)sizeof(glm::vec4));
-        }
-        if (attrUV != -1) {
-            context->glEnableVertexAttribArray(attrUV);
-            context->glVertexAttribPointer(attrUV, 4, GL_FLOAT, false, hop, (void*) (sizeof(glm::vec4) * 2));
-        }
+    if (attrPosOffset != -1 && d.bindOffsetBuf()) {
+        context->glEnableVertexAttribArray(attrPosOffset);
+        context->glVertexAttribPointer(attrPosOffset, 3, GL_FLOAT, false, 0, NULL);
+        context->glVertexAttribDivisor(attrPosOffset, 1);
     }
 
-    // Bind the index buffer and then draw shapes from it.
-    // This invokes the shader program, which accesses the vertex buffers.
-    d.bindIdxOpq();
-    context->glDrawElements(d.drawMode(), d.elemCountOpq(), GL_UNSIGNED_INT, 0);
+    d.bindIdxTra();
+    context->glDrawElementsInstanced(d.drawMode(), d.elemCountTra(), GL_UNSIGNED_INT, 0, d.instanceCount());
+    context->printGLErrorLog();
 
     if (attrPos != -1) context->glDisableVertexAttribArray(attrPos);
-    if (attrNor != -1) context->glDisableVertexAttribArray(attrNor);
     if (attrUV != -1) context->glDisableVertexAttribArray(attrUV);
-
-    context->printGLErrorLog();
+    if (attrPosOffset != -1) {
+        context->glDisableVertexAttribArray(attrPosOffset);
+        // the VAO is shared, so don't leave the divisor for other programs
+        context->glVertexAttribDivisor(attrPosOffset, 0);
+    }
 }
 
-void ShaderProgram::drawInterleavedTra(Drawable &d)
+void ShaderProgram::drawArenaBatch(ChunkArena &arena, const ArenaDrawBatch &batch)
 {
     useMe();
 
-    if (d.elemCountTra() < 0) {
-        throw std::out_of_range("Attempting to draw a drawable with m_count of " + std::to_string(d.elemCountTra()) + "!");
+    if (batch.size() == 0) {
+        return;
     }
 
     setTexture(0);
 
-    const long long hop = 3 * sizeof(glm::vec4);
-
-    // we only use the pos VBO
-    if (d.bindPosTra()) {
-        if (attrPos != -1) {
-            context->glEnableVertexAttribArray(attrPos);
-            context->glVertexAttribPointer(attrPos, 4, GL_FLOAT, false, hop, (void*)0);
-        }
-
-        if (attrNor != -1) {
-            context->glEnableVertexAttribArray(attrNor);
-            context->glVertexAttribPointer(attrNor, 4, GL_FLOAT, false, hop, (void*)sizeof(glm::vec4));
-        }
-        if (attrUV != -1) {
-            context->glEnableVertexAttribArray(attrUV);
-            context->glVertexAttribPointer(attrUV, 4, GL_FLOAT, false, hop, (void*) (sizeof(glm::vec4) * 2));
-        }
-    }
-
-    // Bind the index buffer and then draw shapes from it.
-    // This invokes the shader program, which accesses the vertex buffers.
-    d.bindIdxTra();
-    context->glDrawElements(d.drawMode(), d.elemCountTra(), GL_UNSIGNED_INT, 0);
-
-    if (attrPos != -1) context->glDisableVertexAttribArray(attrPos);
-    if (attrNor != -1) context->glDisableVertexAttribArray(attrNor);
-    if (attrUV != -1) context->glDisableVertexAttribArray(attrUV);
+    // The arena's VAO holds its interleaved buffer, attribute layout and
+    // index buffer; the batch says which ranges of them to draw
+    arena.bindVAO();
+    context->glMultiDrawElementsBaseVertex(GL_TRIANGLES, batch.counts.data(), GL_UNSIGNED_INT,
+                                           batch.indexOffsets.data(), batch.size(), batch.baseVertices.data());
 
     context->printGLErrorLog();
 }
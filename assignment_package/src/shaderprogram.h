@@ -6,6 +6,7 @@
 #include <glm/glm.hpp>
 
 #include "drawable.h"
+#include "scene/chunkarena.h"
 
 
 class ShaderProgram
@@ -22,14 +23,9 @@ public:
 
     int unifModel; // A handle for the "uniform" mat4 representing model matrix in the vertex shader
     int unifModelInvTr; // A handle for the "uniform" mat4 representing inverse transpose of the model matrix in the vertex shader
-    int unifViewProj; // A handle for the "uniform" mat4 representing combined projection and view matrices in the vertex shader
     int unifSampler2D; // A handle for the "uniform" sampler2d to read from for post-processing shaders
-    int unifTime; // A handle for the "uniform" float equal to the elapsed time in milliseconds
-    int unifWeather;
-    int unifTimeOfDay;
 
     int unifDimensions;
-    int unifEye;
 
 public:
     ShaderProgram(OpenGLContext* context);
@@ -40,25 +36,20 @@ public:
 
     // Pass the given model matrix to this shader on the GPU
     void setModelMatrix(const glm::mat4 &model);
-    // Pass the given Projection * View matrix to this shader on the GPU
-    void setViewProjMatrix(const glm::mat4 &vp);
     // Pass the given color to this shader on the GPU
     void setGeometryColor(glm::vec4 color);
-    // Pass the given time to this shader on the GPU
-    void setTime(int time);
     // Pass a texture slot to this shader on the GPU
     void setTexture(int texSlot);
-    // Pass the current time of day in hours to this shader on the GPU
-    void setTimeOfDay(float hours);
 
     // Draw the given object to our screen a single time
     void drawOpq(Drawable &d, int);
     void drawTra(Drawable &d, int);
     // Draw the given object to our screen multiple times using instanced rendering
     void drawInstancedOpq(InstancedDrawable &d);
-    // Draw the given object to our screen where all its data is stored, interleaved, in its pos VBO.
-    void drawInterleavedOpq(Drawable &d);
-    void drawInterleavedTra(Drawable &d);
+    // Draw the transparent mesh of the given object once per instance, textured from the given slot
+    void drawInstancedTra(InstancedDrawable &d, int textureSlot);
+    // Draw every mesh in the batch from the chunk arena's buffers with a single multi-draw call
+    void drawArenaBatch(ChunkArena &arena, const ArenaDrawBatch &batch);
     // Draw function for a post-process shader
     void drawPostShader(Drawable &d, int textureSlot);
 
@@ -0,0 +1,48 @@
+# Benchmarks of the game's Terrain, which need a GL context: a small window
+# is opened for one. Pick a benchmark:
+#   terrainbench --regions | --arena | --draw
+QT += core gui widgets openglwidgets
+
+TARGET = terrainbench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += c++1z
+CONFIG += release
+win32 {
+    LIBS += -lopengl32
+}
+
+INCLUDEPATH += include
+
+include(src/generation.pri)
+
+# the parts of the game the Terrain draws and uploads with
+SOURCES += \
+    src/drawable.cpp \
+    src/openglcontext.cpp \
+    src/frameuniforms.cpp \
+    src/shaderprogram.cpp \
+    src/scene/frustum.cpp \
+    src/scene/chunkarena.cpp \
+    src/scene/chunkupload.cpp \
+    src/scene/terrain.cpp
+
+HEADERS += \
+    src/drawable.h \
+    src/openglcontext.h \
+    src/frameuniforms.h \
+    src/shaderprogram.h \
+    src/scene/frustum.h \
+    src/scene/chunkarena.h \
+    src/scene/terrain.h
+
+SOURCES += tools/terrainbench.cpp
+
+# the terrain shaders --draw draws with
+RESOURCES += glsl.qrc
+
+*-clang*|*-g++* {
+    QMAKE_CXXFLAGS += -Wall -Wextra -pedantic -Winit-self
+    QMAKE_CXXFLAGS += -Wno-strict-aliasing
+}
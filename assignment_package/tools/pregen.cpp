@@ -0,0 +1,670 @@
+// Headless world pregeneration.
+//
+// Generates every zone of a rectangular region on a thread pool, using the
+// same generation stages as the game's BDWorkers but without a window or a
+// GL context, then reports throughput and how long each stage took.
+//
+// With --out, each zone is saved to <dir>/zone_<x>_<z>.blocks: the raw
+// BlockType bytes of its 16 chunks, chunk after chunk in the order the game
+// creates them (x outer, z inner), each in Chunk::getBlocks() order.
+//
+// With --verify, it instead generates and meshes one zone of every biome,
+// hashes their blocks and meshes, and compares them against the golden
+// hashes below. Run it before and after touching Noise, the caves,
+// structures or meshing: it exits with 1 if any world changed. It also
+// checks that the integer-hash noise stays in range and keeps its detail
+// a million blocks out, where the sin hash runs out of float precision:
+// both the raw hashes and the terrain's noise layers and heights built on
+// them. Last, it checks that view frustum culling keeps and drops the
+// boxes it should.
+//
+// With --bench-noise, it times the noise functions on both hash backends,
+// and each of the terrain's noise layers sampled a column and a row at a time.
+
+#include "noise.h"
+#include "noiselayer.h"
+#include "scene/cavefield.h"
+#include "scene/chunk.h"
+#include "scene/frustum.h"
+#include "scene/climatemap.h"
+#include "scene/structureregistry.h"
+#include "scene/workers.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+#define ZONE_WIDTH 64
+
+// Zones that lie entirely inside one biome, with the hashes of their
+// blocks and meshes in the default world (sin-hash noise, exact caves).
+// Only regenerate these for changes that are meant to alter the world.
+struct GoldenZone {
+    const char *biome;
+    int x, z;
+    quint64 blocks, mesh;
+};
+
+static const GoldenZone goldenZones[] = {
+    {"grass lands", -256, -256, 0xf488f9bb315de0ccull, 0x0a63035172a7a66dull},
+    {"archipelago", 1152, -960, 0xc0fc95ba6410b0f1ull, 0xbeaf695d72caf937ull},
+    {"mountains",    128,  192, 0xecdb6aa33b2d1386ull, 0x1dc92921cd1bcab1ull},
+    {"desert",         0,    0, 0x28f51911e2d1e457ull, 0x3f6cecdb6c325905ull},
+    {"ocean",        256,  -64, 0x05a29efd8c8d884dull, 0x03402d66836a28c1ull},
+};
+
+// Nanoseconds spent in each generation stage, summed over every thread
+struct StageTimes {
+    qint64 climate = 0;
+    qint64 columns = 0;
+    qint64 structures = 0;
+    qint64 meshing = 0;
+    qint64 writing = 0;
+
+    void add(const StageTimes &other) {
+        climate += other.climate;
+        columns += other.columns;
+        structures += other.structures;
+        meshing += other.meshing;
+        writing += other.writing;
+    }
+};
+
+// Generates the 16 chunks of the zone with its corner at (x, z), in the
+// same order as Terrain::createBDWorker, timing each stage
+static std::vector<uPtr<Chunk>> generateZone(int x, int z, StructureRegistry &structures, StageTimes &times) {
+    QElapsedTimer timer;
+
+    timer.start();
+    ClimateMap climate(x, z, ZONE_WIDTH);
+    times.climate = timer.nsecsElapsed();
+
+    std::vector<uPtr<Chunk>> chunks;
+    for (int i = x; i < x + ZONE_WIDTH; i += Chunk::WIDTH) {
+        for (int j = z; j < z + ZONE_WIDTH; j += Chunk::WIDTH) {
+            chunks.push_back(mkU<Chunk>(i, j));
+        }
+    }
+
+    timer.restart();
+    for (auto &c : chunks) {
+        c->generateColumns(climate);
+    }
+    times.columns = timer.nsecsElapsed();
+
+    timer.restart();
+    for (auto &c : chunks) {
+        c->generateStructures(climate, structures);
+    }
+    times.structures = timer.nsecsElapsed();
+    for (auto &c : chunks) {
+        c->markGenerated();
+    }
+
+    return chunks;
+}
+
+// Builds every chunk's mesh data the way the VBOWorkers do
+static std::vector<ChunkVBOdata> meshZone(std::vector<uPtr<Chunk>> &chunks) {
+    // chunks in other zones may still be generating, so only link
+    // neighbors inside the zone; faces on its edges mesh against STONE
+    const int side = ZONE_WIDTH / Chunk::WIDTH;
+    for (int i = 0; i < side; ++i) {
+        for (int j = 0; j < side; ++j) {
+            if (i + 1 < side) {
+                chunks[i * side + j]->linkNeighbor(chunks[(i + 1) * side + j], XPOS);
+            }
+            if (j + 1 < side) {
+                chunks[i * side + j]->linkNeighbor(chunks[i * side + j + 1], ZPOS);
+            }
+        }
+    }
+
+    std::vector<ChunkVBOdata> meshes;
+    QMutex meshesLock;
+    for (auto &c : chunks) {
+        VBOWorker(c.get(), &meshes, &meshesLock).run();
+    }
+    return meshes;
+}
+
+// Generates, optionally meshes, and optionally saves one zone
+class ZoneJob : public QRunnable {
+private:
+    int m_x, m_z;
+    StructureRegistry* mp_structures;
+    QString m_outDir;
+    bool m_mesh;
+    StageTimes* mp_times;
+    QMutex* mp_timesLock;
+
+public:
+    ZoneJob(int x, int z, StructureRegistry* structures, const QString &outDir, bool mesh,
+            StageTimes* times, QMutex* timesLock)
+        : m_x(x), m_z(z), mp_structures(structures), m_outDir(outDir), m_mesh(mesh),
+          mp_times(times), mp_timesLock(timesLock)
+    {}
+
+    void run() override {
+        StageTimes times;
+        std::vector<uPtr<Chunk>> chunks = generateZone(m_x, m_z, *mp_structures, times);
+
+        if (m_mesh) {
+            QElapsedTimer timer;
+            timer.start();
+            meshZone(chunks);
+            times.meshing = timer.nsecsElapsed();
+        }
+
+        if (!m_outDir.isEmpty()) {
+            QElapsedTimer timer;
+            timer.start();
+            QFile file(QDir(m_outDir).filePath(QString("zone_%1_%2.blocks").arg(m_x).arg(m_z)));
+            if (file.open(QIODevice::WriteOnly)) {
+                for (auto &c : chunks) {
+                    const auto &blocks = c->getBlocks();
+                    file.write(reinterpret_cast<const char*>(blocks.data()), blocks.size() * sizeof(BlockType));
+                }
+            } else {
+                fprintf(stderr, "could not write %s\n", qPrintable(file.fileName()));
+            }
+            times.writing = timer.nsecsElapsed();
+        }
+
+        mp_timesLock->lock();
+        mp_times->add(times);
+        mp_timesLock->unlock();
+    }
+};
+
+// 64-bit FNV-1a, continued from hash
+static quint64 fnv1a(quint64 hash, const void *data, size_t size) {
+    const unsigned char *bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+template <typename T>
+static quint64 fnv1a(quint64 hash, const std::vector<T> &v) {
+    return fnv1a(hash, v.data(), v.size() * sizeof(T));
+}
+
+// Regenerates every golden zone and compares its hashes.
+// Returns the number of zones that changed.
+static int verifyGoldenZones() {
+    int changed = 0;
+    for (const GoldenZone &golden : goldenZones) {
+        // each zone gets its own registry, so the hashes don't depend
+        // on which zones were generated before it
+        StructureRegistry structures;
+        StageTimes times;
+        std::vector<uPtr<Chunk>> chunks = generateZone(golden.x, golden.z, structures, times);
+        std::vector<ChunkVBOdata> meshes = meshZone(chunks);
+
+        quint64 blocks = 1469598103934665603ull;
+        for (auto &c : chunks) {
+            const auto &b = c->getBlocks();
+            blocks = fnv1a(blocks, b.data(), b.size() * sizeof(BlockType));
+        }
+        quint64 mesh = 1469598103934665603ull;
+        for (auto &m : meshes) {
+            mesh = fnv1a(mesh, m.m_idxDataOpaque);
+            mesh = fnv1a(mesh, m.m_vboDataOpaque);
+            mesh = fnv1a(mesh, m.m_idxDataTransparent);
+            mesh = fnv1a(mesh, m.m_vboDataTransparent);
+        }
+
+        bool ok = blocks == golden.blocks && mesh == golden.mesh;
+        printf("%-12s (%5d, %5d)  blocks %016llx  mesh %016llx  %s\n", golden.biome, golden.x, golden.z,
+               (unsigned long long) blocks, (unsigned long long) mesh, ok ? "ok" : "CHANGED");
+        if (!ok) {
+            printf("%-12s expected       blocks %016llx  mesh %016llx\n", "",
+                   (unsigned long long) golden.blocks, (unsigned long long) golden.mesh);
+            ++changed;
+        }
+    }
+    return changed;
+}
+
+// Side of the square of lattice points checkNoiseBackend samples.
+// Small enough that distinct 24-bit values don't collide by chance.
+#define NOISE_CHECK_SIDE 8
+#define NOISE_CHECK_POINTS (NOISE_CHECK_SIDE * NOISE_CHECK_SIDE)
+
+// Samples every pure integer-hash noise function over a square of lattice
+// points at x = z = +-1,000,000 for a few seeds, failing if any value is
+// outside [0, 1) or any two in a square are equal.
+// Returns the number of squares that failed.
+static int checkNoiseBackend() {
+    struct Function {
+        const char *name;
+        float (*sample)(float x, float z);
+    };
+    static const Function functions[] = {
+        {"noise",  [](float x, float z) { return Noise::noise(glm::vec2(x, z)); }},
+        {"rand",   [](float x, float z) { return Noise::rand(glm::vec2(x, z)); }},
+        {"rand 3D", [](float x, float z) { return Noise::rand(glm::vec3(x, 100.f, z)); }},
+    };
+
+    int failed = 0;
+    for (uint32_t seed : {0u, 1234u, 0xdeadbeefu}) {
+        Noise::setBackend(Noise::Backend::INT_HASH, seed);
+        for (float base : {-1e6f, 1e6f}) {
+            for (const Function &f : functions) {
+                std::vector<float> values;
+                int outOfRange = 0;
+                for (int i = 0; i < NOISE_CHECK_POINTS; ++i) {
+                    float v = f.sample(base + i % NOISE_CHECK_SIDE, base + i / NOISE_CHECK_SIDE);
+                    if (!(v >= 0.f && v < 1.f)) {
+                        ++outOfRange;
+                    }
+                    values.push_back(v);
+                }
+                std::sort(values.begin(), values.end());
+                int distinct = std::unique(values.begin(), values.end()) - values.begin();
+
+                bool ok = outOfRange == 0 && distinct == NOISE_CHECK_POINTS;
+                if (!ok) {
+                    printf("int hash seed %u: %-7s at x = %.0f  %d out of range, %d of %d distinct  FAILED\n",
+                           seed, f.name, base, outOfRange, distinct, NOISE_CHECK_POINTS);
+                    ++failed;
+                }
+            }
+        }
+    }
+    Noise::setBackend(Noise::Backend::SIN_HASH);
+    return failed;
+}
+
+// Windows of 64 x 64 columns checkTerrainFarOut samples around each spot,
+// spread out so that between them they cover a mix of biomes
+#define FAR_CHECK_WINDOWS 32
+// How many times larger or smaller than near the origin the average
+// column-to-column change a million blocks out may be
+#define FAR_CHECK_VARIATION 2.5
+
+// The spread of values over FAR_CHECK_WINDOWS windows starting at
+// (base, base), and the average change from one column to the next along x.
+// Only pairs of columns strictly between lo and hi count towards the
+// change, since fbm sits flat at 0 or 1 over wide areas and how many of
+// those a window lands on says nothing about the noise's detail.
+struct ColumnStats {
+    float min, max;
+    double step;
+    int nonFinite;
+};
+
+// window(x, z, out) fills out with the 64 x 64 values of the window whose
+// corner is at (x, z), x-fastest
+template <typename F>
+static ColumnStats columnStats(int base, float lo, float hi, F &&window) {
+    ColumnStats stats{INFINITY, -INFINITY, 0.0, 0};
+    std::vector<float> values(ZONE_WIDTH * ZONE_WIDTH);
+    long steps = 0;
+    for (int w = 0; w < FAR_CHECK_WINDOWS; ++w) {
+        window(base + w * 5000, base - w * 3000, values.data());
+        for (int i = 0; i < ZONE_WIDTH * ZONE_WIDTH; ++i) {
+            float v = values[i];
+            if (!std::isfinite(v)) {
+                ++stats.nonFinite;
+                continue;
+            }
+            stats.min = std::min(stats.min, v);
+            stats.max = std::max(stats.max, v);
+            if (i % ZONE_WIDTH > 0 && v > lo && v < hi && values[i - 1] > lo && values[i - 1] < hi) {
+                stats.step += std::abs(v - values[i - 1]);
+                ++steps;
+            }
+        }
+    }
+    stats.step /= std::max(steps, 1l);
+    return stats;
+}
+
+// Samples every terrain noise layer, and the terrain height the climate
+// map builds from them, in windows of columns at x = z = +-1,000,000 with
+// the integer-hash noise for a few seeds. Fails if a value leaves the
+// range its kernel can produce, or if the average change from column to
+// column is more than FAR_CHECK_VARIATION times larger or smaller than
+// in the same seed's windows near the origin, as it would be if the
+// terrain went flat, blocky or turned to static.
+// Returns the number of checks that failed.
+static int checkTerrainFarOut() {
+    struct Field {
+        std::string name;
+        float min, max;
+        std::function<void(int, int, float*)> window;
+    };
+    std::vector<Field> fields;
+    static const char *layerNames[TerrainNoise::LAYER_COUNT] = {
+        "height blend", "humidity blend", "ocean weight", "grass cells", "grass detail",
+        "mountain 1", "mountain 2", "archipelago big", "archipelago small", "desert dunes",
+    };
+    for (int l = 0; l < TerrainNoise::LAYER_COUNT; ++l) {
+        const NoiseLayer &layer = TerrainNoise::layers[l];
+        float min = 0.f, max = 1.f;
+        if (layer.kernel == NoiseLayer::PERLIN) {
+            min = -1.f;
+        } else if (layer.kernel == NoiseLayer::WORLEY) {
+            // 1 - 0.02 minus the distance to the closest feature point,
+            // which is never more than a cell's diagonal away
+            min = 1.f - std::sqrt(2.f) - 0.02f;
+            max = 0.98f;
+        }
+        fields.push_back({layerNames[l], min, max, [&layer](int x, int z, float *out) {
+            for (int j = 0; j < ZONE_WIDTH; ++j) {
+                layer.sampleRow(x, z + j, ZONE_WIDTH, out + j * ZONE_WIDTH);
+            }
+        }});
+    }
+    fields.push_back({"terrain height", 0.f, float(Chunk::HEIGHT - 1), [](int x, int z, float *out) {
+        ClimateMap climate(x, z, ZONE_WIDTH);
+        for (int j = 0; j < ZONE_WIDTH; ++j) {
+            for (int i = 0; i < ZONE_WIDTH; ++i) {
+                out[i + j * ZONE_WIDTH] = climate.at(x + i, z + j).terrainHeight;
+            }
+        }
+    }});
+
+    int failed = 0;
+    for (uint32_t seed : {0u, 1234u, 0xdeadbeefu}) {
+        Noise::setBackend(Noise::Backend::INT_HASH, seed);
+        for (const Field &field : fields) {
+            ColumnStats near = columnStats(0, field.min, field.max, field.window);
+            for (int base : {-1000000, 1000000}) {
+                ColumnStats far = columnStats(base, field.min, field.max, field.window);
+                double ratio = far.step / std::max(near.step, 1e-9);
+                bool inRange = far.nonFinite == 0 && far.min >= field.min && far.max <= field.max;
+                bool varies = ratio <= FAR_CHECK_VARIATION && ratio >= 1.0 / FAR_CHECK_VARIATION;
+                if (!inRange || !varies) {
+                    printf("int hash seed %u: %-17s at x = %d  range [%.3f, %.3f] of [%.3f, %.3f], "
+                           "%d not finite, column step %.5f vs %.5f near the origin  FAILED\n",
+                           seed, field.name.c_str(), base, far.min, far.max, field.min, field.max,
+                           far.nonFinite, far.step, near.step);
+                    ++failed;
+                }
+            }
+        }
+    }
+    Noise::setBackend(Noise::Backend::SIN_HASH);
+    return failed;
+}
+
+// Tests boxes against the frustum of a camera at (8, 150, 8) looking along
+// -z, with a 45 degree field of view and a far plane 1000 blocks out.
+// Returns the number of boxes it kept or dropped wrongly.
+static int checkFrustum() {
+    struct Case {
+        const char *name;
+        glm::vec3 min, max;
+        bool visible;
+    };
+    static const Case cases[] = {
+        {"ahead of the camera",      {0, 140, -64},   {16, 160, -48},   true},
+        {"around the camera",        {0, 0, 0},       {16, 256, 16},    true},
+        {"holding the whole view",   {-2000, -2000, -2000}, {2000, 2000, 2000}, true},
+        {"behind the camera",        {0, 140, 64},    {16, 160, 80},    false},
+        {"past the far plane",       {0, 0, -2000},   {16, 256, -1984}, false},
+        {"below the view",           {0, 0, -32},     {16, 60, -16},    false},
+        {"off to the side",          {600, 140, -64}, {616, 160, -48},  false},
+    };
+
+    glm::vec3 eye(8, 150, 8);
+    Frustum frustum(glm::perspective(glm::radians(45.f), 1.5f, 0.1f, 1000.f)
+                    * glm::lookAt(eye, eye + glm::vec3(0, 0, -1), glm::vec3(0, 1, 0)));
+    int failed = 0;
+    for (const Case &c : cases) {
+        if (frustum.intersects(c.min, c.max) != c.visible) {
+            printf("frustum: box %s was %s  FAILED\n", c.name, c.visible ? "culled" : "kept");
+            ++failed;
+        }
+    }
+    return failed;
+}
+
+// Times the noise functions the terrain is built from on each backend,
+// in nanoseconds per call
+static void benchNoiseBackends() {
+    struct Backend {
+        const char *name;
+        Noise::Backend backend;
+    };
+    static const Backend backends[] = {
+        {"sin hash", Noise::Backend::SIN_HASH},
+        {"int hash", Noise::Backend::INT_HASH},
+    };
+
+    // keeps the calls from being optimized out
+    volatile float sink = 0;
+    for (const Backend &b : backends) {
+        Noise::setBackend(b.backend, 1234);
+        QElapsedTimer timer;
+
+        const int noiseCalls = 4000000;
+        timer.start();
+        for (int i = 0; i < noiseCalls; ++i) {
+            sink = sink + Noise::noise(glm::vec2(i & 1023, i >> 10));
+        }
+        double noiseNs = double(timer.nsecsElapsed()) / noiseCalls;
+
+        const int perlinCalls = 1000000;
+        timer.restart();
+        for (int i = 0; i < perlinCalls; ++i) {
+            sink = sink + Noise::perlin(glm::vec3(i & 127, (i >> 7) & 127, i >> 14), 0.03f);
+        }
+        double perlinNs = double(timer.nsecsElapsed()) / perlinCalls;
+
+        const int fbmCalls = 200000;
+        timer.restart();
+        for (int i = 0; i < fbmCalls; ++i) {
+            sink = sink + Noise::fbm((i & 511) * 0.004f, (i >> 9) * 0.004f);
+        }
+        double fbmNs = double(timer.nsecsElapsed()) / fbmCalls;
+
+        printf("%s: noise %6.1f ns  perlin 3D %6.1f ns  fbm %7.1f ns\n", b.name, noiseNs, perlinNs, fbmNs);
+    }
+    Noise::setBackend(Noise::Backend::SIN_HASH);
+}
+
+// Names of TerrainNoise's layers, in their order
+static const char *layerNames[] = {
+    "HEIGHT_BLEND", "HUMIDITY_BLEND", "OCEAN_WEIGHT",
+    "GRASS_CELLS", "GRASS_DETAIL",
+    "MOUNTAIN_1", "MOUNTAIN_2",
+    "ARCHIPELAGO_BIG", "ARCHIPELAGO_SMALL",
+    "DESERT_DUNES",
+};
+static_assert(sizeof(layerNames) / sizeof(layerNames[0]) == TerrainNoise::LAYER_COUNT,
+              "every noise layer needs a name");
+
+// Times every terrain noise layer over a zone's columns, sampled one column
+// at a time and a row at a time, in nanoseconds per column. Also counts the
+// columns where the two disagree, which should be none.
+static void benchNoiseLayers() {
+    static const char *kernels[] = {"fbm", "perlin", "worley"};
+    const int x = -1024, z = 512;
+    std::vector<float> row(ZONE_WIDTH);
+    volatile float sink = 0;
+
+    for (int l = 0; l < TerrainNoise::LAYER_COUNT; ++l) {
+        const NoiseLayer &layer = TerrainNoise::layers[l];
+        QElapsedTimer timer;
+
+        timer.start();
+        for (int j = 0; j < ZONE_WIDTH; ++j) {
+            for (int i = 0; i < ZONE_WIDTH; ++i) {
+                sink = sink + layer.sample(x + i, z + j);
+            }
+        }
+        double columnNs = double(timer.nsecsElapsed()) / (ZONE_WIDTH * ZONE_WIDTH);
+
+        timer.restart();
+        for (int j = 0; j < ZONE_WIDTH; ++j) {
+            layer.sampleRow(x, z + j, ZONE_WIDTH, row.data());
+            sink = sink + row[0];
+        }
+        double rowNs = double(timer.nsecsElapsed()) / (ZONE_WIDTH * ZONE_WIDTH);
+
+        int mismatches = 0;
+        for (int j = 0; j < ZONE_WIDTH; ++j) {
+            layer.sampleRow(x, z + j, ZONE_WIDTH, row.data());
+            for (int i = 0; i < ZONE_WIDTH; ++i) {
+                mismatches += row[i] != layer.sample(x + i, z + j);
+            }
+        }
+
+        QString octaves = layer.kernel == NoiseLayer::WORLEY ? "" : QString("%1 octaves").arg(layer.octaves);
+        printf("%-18s %-6s %-10s  column %7.1f ns  row %7.1f ns  mismatches %d\n",
+               layerNames[l], kernels[layer.kernel], qPrintable(octaves), columnNs, rowNs, mismatches);
+    }
+}
+
+static int floorToZone(int v) {
+    return v >= 0 ? v / ZONE_WIDTH * ZONE_WIDTH : -((-v + ZONE_WIDTH - 1) / ZONE_WIDTH * ZONE_WIDTH);
+}
+
+static void printStage(const char *name, qint64 ns, int chunks, qint64 totalNs) {
+    printf("  %-11s %10.1f ms  %8.3f ms/chunk  %5.1f%%\n", name, ns * 1e-6, ns * 1e-6 / chunks,
+           totalNs > 0 ? 100.0 * ns / totalNs : 0.0);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Pregenerates a region of the world without a window.");
+    parser.addHelpOption();
+    parser.addOption({"region", "Block-space region minX,minZ,maxX,maxZ, widened to whole zones.",
+                      "region", "-256,-256,256,256"});
+    parser.addOption({"threads", "Number of generation threads.", "n",
+                      QString::number(QThread::idealThreadCount())});
+    parser.addOption({"out", "Directory to save the zones to. Nothing is saved without it.", "dir"});
+    parser.addOption({"mesh", "Also build every chunk's mesh data, like the VBOWorkers do."});
+    parser.addOption({"seed", "Generate a seeded world with the integer-hash noise.", "n"});
+    parser.addOption({"caves", "Cave quality: exact, refined or fast.", "quality", "exact"});
+    parser.addOption({"verify", "Check the golden zones instead, exiting with 1 if any world changed."});
+    parser.addOption({"bench-noise", "Time the noise functions and noise layers instead."});
+    parser.process(app);
+
+    if (parser.isSet("verify")) {
+        if (parser.isSet("seed") || parser.value("caves") != "exact") {
+            fprintf(stderr, "--verify checks the default world, so it can't be used with --seed or --caves\n");
+            return 1;
+        }
+        int changed = verifyGoldenZones();
+        int noiseFailed = checkNoiseBackend();
+        int terrainFailed = checkTerrainFarOut();
+        int frustumFailed = checkFrustum();
+        if (changed > 0) {
+            printf("%d of %d golden zones changed\n", changed, int(sizeof(goldenZones) / sizeof(goldenZones[0])));
+        } else {
+            printf("all golden zones match\n");
+        }
+        if (noiseFailed > 0) {
+            printf("%d integer-hash noise checks failed\n", noiseFailed);
+        } else {
+            printf("integer-hash noise is in range and distinct at x = +-1,000,000\n");
+        }
+        if (terrainFailed > 0) {
+            printf("%d integer-hash terrain checks failed\n", terrainFailed);
+        } else {
+            printf("integer-hash terrain layers and heights are in range and as varied at x = +-1,000,000 as near the origin\n");
+        }
+        if (frustumFailed > 0) {
+            printf("%d frustum checks failed\n", frustumFailed);
+        } else {
+            printf("frustum culling keeps and drops the expected boxes\n");
+        }
+        return changed > 0 || noiseFailed > 0 || terrainFailed > 0 || frustumFailed > 0 ? 1 : 0;
+    }
+
+    if (parser.isSet("bench-noise")) {
+        benchNoiseBackends();
+        benchNoiseLayers();
+        return 0;
+    }
+
+    QStringList region = parser.value("region").split(',');
+    if (region.size() != 4) {
+        fprintf(stderr, "--region needs four comma-separated numbers\n");
+        return 1;
+    }
+    int minX = floorToZone(region[0].toInt());
+    int minZ = floorToZone(region[1].toInt());
+    int maxX = floorToZone(region[2].toInt() + ZONE_WIDTH - 1);
+    int maxZ = floorToZone(region[3].toInt() + ZONE_WIDTH - 1);
+    if (maxX <= minX || maxZ <= minZ) {
+        fprintf(stderr, "--region is empty\n");
+        return 1;
+    }
+
+    if (parser.isSet("seed")) {
+        Noise::setBackend(Noise::Backend::INT_HASH, parser.value("seed").toUInt());
+    }
+    QString caves = parser.value("caves");
+    if (caves == "refined") {
+        CaveField::setQuality(CaveField::REFINED);
+    } else if (caves == "fast") {
+        CaveField::setQuality(CaveField::FAST);
+    }
+
+    QString outDir = parser.value("out");
+    if (!outDir.isEmpty() && !QDir().mkpath(outDir)) {
+        fprintf(stderr, "could not create %s\n", qPrintable(outDir));
+        return 1;
+    }
+
+    int threads = qMax(1, parser.value("threads").toInt());
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+
+    StructureRegistry structures;
+    StageTimes times;
+    QMutex timesLock;
+
+    int zones = 0;
+    QElapsedTimer wall;
+    wall.start();
+    for (int x = minX; x < maxX; x += ZONE_WIDTH) {
+        for (int z = minZ; z < maxZ; z += ZONE_WIDTH) {
+            pool.start(new ZoneJob(x, z, &structures, outDir, parser.isSet("mesh"), &times, &timesLock));
+            ++zones;
+        }
+    }
+    pool.waitForDone();
+    qint64 wallNs = wall.nsecsElapsed();
+
+    int chunks = zones * (ZONE_WIDTH / Chunk::WIDTH) * (ZONE_WIDTH / Chunk::WIDTH);
+    qint64 stagesNs = times.climate + times.columns + times.structures + times.meshing + times.writing;
+
+    printf("region [%d, %d] x [%d, %d]: %d zones, %d chunks on %d threads\n",
+           minX, maxX, minZ, maxZ, zones, chunks, threads);
+    printf("wall time %.1f ms, %.1f chunks/s\n", wallNs * 1e-6, chunks / (wallNs * 1e-9));
+    printf("stage times, summed over threads:\n");
+    printStage("climate", times.climate, chunks, stagesNs);
+    printStage("columns", times.columns, chunks, stagesNs);
+    printStage("structures", times.structures, chunks, stagesNs);
+    if (parser.isSet("mesh")) {
+        printStage("meshing", times.meshing, chunks, stagesNs);
+    }
+    if (!outDir.isEmpty()) {
+        printStage("writing", times.writing, chunks, stagesNs);
+    }
+
+    return 0;
+}
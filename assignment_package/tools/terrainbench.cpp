@@ -0,0 +1,267 @@
+// Terrain benchmarks.
+//
+// Unlike pregen, these run the game's own Terrain, which uploads its chunk
+// meshes as they come in, so they need a GL context. The tool opens a
+// small window for one, loads the spawn area around (0, 175, 0) the way
+// the game does, runs the chosen benchmark, prints the results and exits.
+//
+// With --regions, it times filling and reading a 64 x 64 x 64 box over a
+// 4 x 4 chunk area one block at a time and through the region API.
+//
+// With --arena, it reports how full and fragmented the chunk arena is after
+// the startup load and along a 320-block walk with the workers running.
+//
+// With --draw, it draws the spawn area from a grid of views looking four
+// ways, and reports how many chunks were drawn, culled and occluded, the
+// CPU time of Terrain::draw, and the time until the GPU finished.
+
+#include "frameuniforms.h"
+#include "openglcontext.h"
+#include "renderdistance.h"
+#include "shaderprogram.h"
+#include "scene/terrain.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QSurfaceFormat>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+
+// Times a benchmark is repeated; the fastest run is reported
+#define BENCH_RUNS 5
+
+static const glm::vec3 spawnPos(0, 175, 0);
+
+// Runs the startup load and waits for every chunk of it to be buffered
+static void loadSpawnArea(Terrain &terrain) {
+    terrain.loadSpawnArea(spawnPos);
+    while (!terrain.spawnAreaLoaded()) {
+        terrain.multithread(spawnPos, spawnPos, 0.f);
+        QThread::msleep(1);
+    }
+}
+
+// The fastest of BENCH_RUNS runs of f, in milliseconds
+static double fastestMs(const std::function<void()> &f) {
+    double best = 0.0;
+    for (int run = 0; run < BENCH_RUNS; ++run) {
+        QElapsedTimer timer;
+        timer.start();
+        f();
+        double ms = timer.nsecsElapsed() * 1e-6;
+        best = run == 0 ? ms : std::min(best, ms);
+    }
+    return best;
+}
+
+// Fills and reads a 64 x 64 x 64 box in the spawn zone, without remeshing,
+// block by block and through the region API
+static void benchRegions(OpenGLContext&, Terrain &terrain) {
+    const glm::ivec3 min(0, 64, 0), max(64, 128, 64);
+    const glm::ivec3 size = max - min;
+
+    double setMs = fastestMs([&]() {
+        for (int z = min.z; z < max.z; ++z) {
+            for (int y = min.y; y < max.y; ++y) {
+                for (int x = min.x; x < max.x; ++x) {
+                    terrain.setBlockAt(x, y, z, STONE);
+                }
+            }
+        }
+    });
+    double fillMs = fastestMs([&]() {
+        terrain.fillRegion(min, max, DIRT, false);
+    });
+
+    std::vector<BlockType> blocks(size.x * size.y * size.z);
+    double getMs = fastestMs([&]() {
+        BlockType *out = blocks.data();
+        for (int z = min.z; z < max.z; ++z) {
+            for (int y = min.y; y < max.y; ++y) {
+                for (int x = min.x; x < max.x; ++x) {
+                    *out++ = terrain.getBlockAt(x, y, z);
+                }
+            }
+        }
+    });
+    double readMs = fastestMs([&]() {
+        terrain.readRegion(min, max, blocks.data(), EMPTY);
+    });
+    int wrong = std::count_if(blocks.begin(), blocks.end(), [](BlockType b) { return b != DIRT; });
+
+    printf("64^3 box, fastest of %d runs:\n", BENCH_RUNS);
+    printf("  write  setBlockAt per block %8.3f ms   fillRegion %8.3f ms\n", setMs, fillMs);
+    printf("  read   getBlockAt per block %8.3f ms   readRegion %8.3f ms\n", getMs, readMs);
+    if (wrong > 0) {
+        printf("  %d blocks read back wrong\n", wrong);
+    }
+}
+
+static void printArena(const Terrain &terrain, const char *when) {
+    ChunkArenaStats a = terrain.getArenaStats();
+    printf("%-9s %4d meshes  vertices %.1fM of %.1fM (%.0f%%)  indices %.1fM of %.1fM (%.0f%%)  "
+           "%d free blocks, %.1f%% fragmented  %d grows\n",
+           when, a.meshes, a.verticesUsed * 1e-6, a.vertexCapacity * 1e-6, 100.0 * a.verticesUsed / a.vertexCapacity,
+           a.indicesUsed * 1e-6, a.indexCapacity * 1e-6, 100.0 * a.indicesUsed / a.indexCapacity,
+           a.vertexFreeBlocks, 100.0 * a.vertexFragmentation, a.grows);
+}
+
+// Walks 320 blocks out from spawn, checking for new zones every 16 blocks
+// like the game does every half second. The workers catch up after each
+// step, as they would for a player walking at a normal pace.
+static void benchArena(OpenGLContext&, Terrain &terrain) {
+    printArena(terrain, "spawn");
+    glm::vec3 prev = spawnPos;
+    for (int x = 16; x <= 320; x += 16) {
+        glm::vec3 pos(x, spawnPos.y, x / 2);
+        terrain.multithread(pos, prev, 1.f);
+        prev = pos;
+        for (int i = 0; i < 3; ++i) {
+            QThreadPool::globalInstance()->waitForDone();
+            terrain.multithread(pos, pos, 0.f);
+        }
+        if (x % 64 == 0) {
+            char when[16];
+            snprintf(when, sizeof(when), "x = %d", x);
+            printArena(terrain, when);
+        }
+    }
+}
+
+// Draws the spawn area at the game's starting draw radius from a grid of
+// views 2 blocks above the ground, each looking four ways
+static void benchDraw(OpenGLContext &context, Terrain &terrain) {
+    ShaderProgram lambert(&context);
+    lambert.create(":/glsl/lambert.vert.glsl", ":/glsl/lambert.frag.glsl");
+    FrameUniforms uniforms(&context);
+    uniforms.create();
+
+    const int radius = Chunk::WIDTH * RenderDistanceConfig().startRadius;
+    const glm::vec3 directions[4] = {{1, 0, 0}, {-1, 0, 0}, {0, -0.3f, 1}, {0, 0.2f, -1}};
+    int views = 0;
+    double drawn = 0, culled = 0, occluded = 0, cpuMs = 0, gpuMs = 0;
+    float maxCpuMs = 0.f, maxGpuMs = 0.f;
+    for (int x = -56; x <= 104; x += 32) {
+        for (int z = -56; z <= 104; z += 32) {
+            int top = Chunk::HEIGHT - 1;
+            while (top > 0 && !Chunk::isSolid(terrain.getBlockAt(x, top, z))) {
+                --top;
+            }
+            glm::vec3 eye(x + 0.5f, top + 2.6f, z + 0.5f);
+            for (const glm::vec3 &dir : directions) {
+                FrameUniforms::Data data;
+                data.viewProj = glm::perspective(glm::radians(45.f), 1.5f, 0.1f, 1000.f)
+                                * glm::lookAt(eye, eye + dir, glm::vec3(0, 1, 0));
+                data.viewProjInv = glm::inverse(data.viewProj);
+                data.eye = glm::vec4(eye, 1.f);
+                data.time = 0;
+                data.timeOfDay = 12.f;
+                data.weather = 0.f;
+                data.padding = 0.f;
+                uniforms.upload(data);
+                Frustum frustum(data.viewProj);
+
+                // the first draw from a new section re-sorts transparent
+                // faces, so time the second, as most frames would be
+                for (int frame = 0; frame < 2; ++frame) {
+                    context.glFinish();
+                    QElapsedTimer timer;
+                    timer.start();
+                    terrain.draw(eye.x - radius, eye.x + radius, eye.z - radius, eye.z + radius,
+                                 frustum, eye, &lambert);
+                    context.glFinish();
+                    float frameMs = timer.nsecsElapsed() * 1e-6f;
+                    if (frame == 1) {
+                        const TerrainDrawStats &stats = terrain.getDrawStats();
+                        ++views;
+                        drawn += stats.drawn;
+                        culled += stats.culled;
+                        occluded += stats.occluded;
+                        cpuMs += stats.cpuMs;
+                        gpuMs += frameMs;
+                        maxCpuMs = std::max(maxCpuMs, stats.cpuMs);
+                        maxGpuMs = std::max(maxGpuMs, frameMs);
+                    }
+                }
+            }
+        }
+    }
+    uniforms.destroy();
+
+    printf("%d views at a %d-chunk radius, per view:\n", views, radius / Chunk::WIDTH);
+    printf("  chunks  %.1f drawn, %.1f culled, %.1f occluded\n", drawn / views, culled / views, occluded / views);
+    printf("  Terrain::draw CPU time   %.3f ms mean, %.3f ms max\n", cpuMs / views, maxCpuMs);
+    printf("  until the GPU finished   %.3f ms mean, %.3f ms max\n", gpuMs / views, maxGpuMs);
+}
+
+// A widget that only exists for its GL context. It runs the benchmark
+// once the context is ready, then quits.
+class BenchContext : public OpenGLContext {
+private:
+    std::function<void(OpenGLContext&, Terrain&)> m_bench;
+
+public:
+    BenchContext(std::function<void(OpenGLContext&, Terrain&)> bench)
+        : OpenGLContext(nullptr), m_bench(bench)
+    {}
+
+    void initializeGL() override {
+        initializeOpenGLFunctions();
+        initializeMultiDraw();
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_CULL_FACE);
+
+        Terrain terrain(this);
+        QElapsedTimer timer;
+        timer.start();
+        loadSpawnArea(terrain);
+        printf("spawn area loaded in %lld ms\n", timer.elapsed());
+        m_bench(*this, terrain);
+        // let the terrain's workers finish before it goes away
+        QThreadPool::globalInstance()->waitForDone();
+        QTimer::singleShot(0, qApp, &QCoreApplication::quit);
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks the game's Terrain in a GL context.");
+    parser.addHelpOption();
+    parser.addOption({"regions", "Time block-by-block and region reads and writes of a 64^3 box."});
+    parser.addOption({"arena", "Report the chunk arena's use after the startup load and along a walk."});
+    parser.addOption({"draw", "Time Terrain::draw from a grid of views over the spawn area."});
+    parser.process(app);
+
+    std::function<void(OpenGLContext&, Terrain&)> bench;
+    if (parser.isSet("regions")) {
+        bench = benchRegions;
+    } else if (parser.isSet("arena")) {
+        bench = benchArena;
+    } else if (parser.isSet("draw")) {
+        bench = benchDraw;
+    } else {
+        fprintf(stderr, "choose a benchmark: --regions, --arena or --draw\n");
+        return 1;
+    }
+
+    // the same context the game asks for
+    QSurfaceFormat format;
+    format.setVersion(4, 0);
+    format.setOption(QSurfaceFormat::DeprecatedFunctions, false);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    QSurfaceFormat::setDefaultFormat(format);
+
+    BenchContext context(bench);
+    context.resize(64, 64);
+    context.show();
+    return app.exec();
+}